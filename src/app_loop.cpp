@@ -1,45 +1,128 @@
 #include <cstdint>
-#include <pid/pid_algo.h>
+#include <cstdio>
+#include "oven/pid_ctrl.h"
 #include "oven/oven_hardware.h"
 #include "oven/oven_operation.h"
+#include "oven/job_queue.h"
+#include "app_settings.h"
+#include "devices/control_timer.h"
+#include "fixed_point_bench.h"
+#include "lvgl_driver/display_bench.h"
+#include "lvgl_driver/display_profiler.h"
 #include "ui/ui.h"
 #include "libpekin.h"
+#include "error_handler.h"
 
-static OvenHardware oven_;
+/// Rate at which the oven state machine/PID runs, independent of UI load.
+static constexpr uint16_t control_tick_period_ms = 100;
+static_assert(control_tick_period_ms == OvenOperation::min_control_period_ms);
 
 static uint64_t getMillis() { return Libp::getMillis(); }
 
+#if MOCK_OVEN
+static OvenSim oven_sim_(getMillis);
+static OvenHardware oven_(oven_sim_);
+#else
+static OvenHardware oven_;
+#endif
+
 // 40 10 5
 
-static Libp::PidAlgo pid_algo_(
+static PidCtrl pid_ctrl_(
         40, 10, 5,
         0, 100,
         // getMillis overflow is okay as oven won't be on for months.
         getMillis);
 
-static OvenOperation oven_operation_(oven_, pid_algo_, getMillis);
+static OvenOperation oven_operation_(oven_, pid_ctrl_, getMillis);
 
-static void processOvenEvents()
+/// Created on first use, after the settings have been loaded
+static JobQueue& getJobQueue()
+{
+    static JobQueue job_queue(oven_operation_, getReflowProfiles(), getMillis);
+    return job_queue;
+}
+
+/// Called from the control timer interrupt
+static void controlTick()
 {
     oven_operation_.process();
 }
 
+static void processOvenEvents()
+{
+    oven_operation_.dispatchEvents();
+    getJobQueue().process();
+}
+
+/// Sensor fault the operator has been told about, 0 = none
+static uint8_t shown_sensor_fault_ = 0;
+
+static void acknowledgeSensorFault()
+{
+    // Shown again by updateUi if the fault is still present
+    oven_.clearSensorFault();
+    shown_sensor_fault_ = 0;
+}
+
+/// Report a new thermocouple fault on the UART and to the operator
+static void checkSensorFault(uint8_t fault)
+{
+    if (fault == 0 || fault == shown_sensor_fault_)
+        return;
+    shown_sensor_fault_ = fault;
+
+    const char* cause = getThermocoupleFaultText(fault);
+    getErrHndlr().report("thermocouple fault 0x%02x: %s\r\n", (int)fault, cause);
+    static char text[64];
+    snprintf(text, sizeof(text), "%s.\nOven turned off.", cause);
+    createModalMbox(text, ModalMboxType::okay, acknowledgeSensorFault, nullptr);
+}
+
+/// Anomaly the operator has been told about, cleared when the next
+/// operation starts
+static OvenMonitor::Anomaly shown_anomaly_ = OvenMonitor::Anomaly::none;
+
+static void checkAnomaly(OvenMonitor::Anomaly anomaly)
+{
+    if (anomaly == shown_anomaly_)
+        return;
+    shown_anomaly_ = anomaly;
+    if (anomaly == OvenMonitor::Anomaly::none)
+        return;
+
+    const char* cause = OvenMonitor::getAnomalyText(anomaly);
+    getErrHndlr().report("oven anomaly %d: %s\r\n", (int)anomaly, cause);
+    static char text[64];
+    snprintf(text, sizeof(text), "%s.\nOven turned off.", cause);
+    createModalMbox(text, ModalMboxType::okay, nullptr, nullptr);
+}
+
 static void updateUi()
 {
-    statusHeaderUpdate(oven_.getPowerLevel(), oven_.getTemp());
-    switch (oven_operation_.getState()) {
+    OvenOperation::Snapshot snapshot = oven_operation_.getSnapshot();
+    checkSensorFault(snapshot.sensor_fault);
+    checkAnomaly(snapshot.anomaly);
+    statusHeaderUpdate(snapshot.power_level, snapshot.temp);
+    pageJobQueueRefreshUi();
+    switch (snapshot.state) {
     case OvenOperation::State::baking:
-        pageBakerunRefreshUi(oven_operation_.getElapsedTime());
+        pageBakerunRefreshUi(snapshot.elapsed_s);
         break;
     case OvenOperation::State::reflow_tracking:
-        pageReflowrunRefreshUi(oven_operation_.getElapsedTime(), oven_.getTemp(), false);
+        pageReflowrunRefreshUi(snapshot.elapsed_s, snapshot.start_offset_s, snapshot.temp, snapshot.temp_rate, false);
         break;
     case OvenOperation::State::reflow_cooling:
-        pageReflowrunRefreshUi(oven_operation_.getElapsedTime(), oven_.getTemp(), true);
+        pageReflowrunRefreshUi(snapshot.elapsed_s, snapshot.start_offset_s, snapshot.temp, snapshot.temp_rate, true);
+        break;
+    case OvenOperation::State::characterize:
+        pageManualOvenOpRefreshUi(oven_operation_.getCharacterizationPhase());
         break;
     case OvenOperation::State::reflow_warming:
     case OvenOperation::State::manual_pwr:
     case OvenOperation::State::manual_temp:
+    case OvenOperation::State::autotune:
+    case OvenOperation::State::cooldown:
     case OvenOperation::State::stopped:
         // nothing to do
         break;
@@ -50,6 +133,7 @@ static void updateUi()
 
 #if PRINT_DEBUG_INFO
 #include "lvgl/lvgl.h"
+#include "ui/ui_view_model.h"
 static void outputDebugInfo()
 {
     static uint32_t last = 0;
@@ -66,24 +150,56 @@ static void outputDebugInfo()
                 (int)mon.free_biggest_size);
         last = now;
     }
+    static uint32_t last_stats = 0;
+    if ((now - last_stats) > 10000) {
+        ControlTimerStats stats = getControlTimerStats();
+        getErrHndlr().report("tick n=%d max_jitter=%dus max_exec=%dus avg_exec=%dus overruns=%d\r\n",
+                (int)stats.ticks, (int)stats.max_jitter_us, (int)stats.max_exec_us,
+                (int)(stats.ticks ? stats.total_exec_us / stats.ticks : 0), (int)stats.overruns);
+        for (uint8_t i = 0; i < control_jitter_buckets - 1; i++) {
+            getErrHndlr().report("  <%dus: %d\r\n",
+                    (int)control_jitter_bucket_us[i], (int)stats.jitter_hist[i]);
+        }
+        getErrHndlr().report("  >=%dus: %d\r\n",
+                (int)control_jitter_bucket_us[control_jitter_buckets - 2],
+                (int)stats.jitter_hist[control_jitter_buckets - 1]);
+        ViewStats view_stats = getViewStats();
+        getErrHndlr().report("ui updates=%d redraws=%d saved=%d\r\n",
+                (int)view_stats.updates, (int)view_stats.redraws,
+                (int)(view_stats.updates - view_stats.redraws));
+        last_stats = now;
+    }
 }
 #endif
 
-#include "app_settings.h"
-
 void runMainProgLoop()
 {
+#if RUN_FIXED_POINT_BENCH
+    runFixedPointBench();
+#endif
     AppSettings::Data& settings = getSettings();
 
-    pid_algo_.setPidParams(
+    pid_ctrl_.setPidParams(
             settings.pid_params.kp,
             settings.pid_params.ki,
             settings.pid_params.kd);
-    buildUi(&oven_operation_, &pid_algo_);
+    oven_operation_.setOvenModel(settings.oven_model);
+    oven_operation_.setControlPeriod(settings.control_period_ms);
+    buildUi(&oven_operation_, &pid_ctrl_, &getJobQueue());
+#if RUN_DISPLAY_BENCH
+    runDisplayBench();
+#endif
+    initControlTimer(control_tick_period_ms, controlTick);
     uint32_t timestamp_ms = Libp::getMillis();
 
     while (true) {
+#if PROFILE_DISPLAY
+        profileTaskHandlerStart();
+        lv_task_handler();
+        profileTaskHandlerEnd();
+#else
         lv_task_handler();
+#endif
         uint32_t now = Libp::getMillis();
         lv_tick_inc(now - timestamp_ms);
         timestamp_ms = now;
@@ -91,6 +207,9 @@ void runMainProgLoop()
         updateUi();
 #if PRINT_DEBUG_INFO
         outputDebugInfo();
+#endif
+#if PROFILE_DISPLAY
+        outputDisplayProfile();
 #endif
         Libp::delayMs(5);
     }
@@ -5,6 +5,7 @@
 #include <cstring>
 #include <flash/eeprom_stm32f1xx.h>
 #include "reflow/reflow_profiles.h"
+#include "oven/oven_model.h"
 #include "touch/resistive_touch.h"
 #include "misc_math.h"
 
@@ -26,6 +27,12 @@ public:
         Libp::ResistiveTouch::CalibrationMatrix touch_calib_mtx;
         ReflowProfiles::Profile profiles[ReflowProfiles::max_profiles_];
         PidParams pid_params;
+        /// PID sampling/SSR period, see @p OvenOperation::setControlPeriod
+        uint16_t control_period_ms;
+        /// Hz, see @p setOvenSsrMainsFreq
+        uint8_t mains_freq;
+        /// Thermal model fitted by the last characterization run
+        OvenModel oven_model;
 
         /**
          * Convert temperature to the currently configured units.
@@ -105,7 +112,7 @@ private:
     static constexpr uint32_t flash_size = 384*1024;
     static constexpr uint32_t flash_end_addr = FLASH_BASE + flash_size - 1;
     static constexpr uint32_t eeprom_base_addr = flash_end_addr - (flash_page_size * 2) + 1;
-    static constexpr uint16_t magic_signature = 0x1245;
+    static constexpr uint16_t magic_signature = 0x1249;
 
     LibpStm32::Eeprom<Data, eeprom_base_addr, magic_signature> eeprom;
     Data data_ = []() {
@@ -120,6 +127,9 @@ private:
         data.profiles[0] = ReflowProfiles::sn63pb37;
         data.profiles[1] = ReflowProfiles::pbfree;
         data.pid_params = { 40, 10, 5 }; // 500, 50, 30000
+        data.control_period_ms = 1000;
+        data.mains_freq = 60;
+        data.oven_model = default_oven_model;
 
         return data;
     }();
@@ -0,0 +1,102 @@
+#include <cstdint>
+#include <cstring>
+#include "clock_stm32f1xx.h"
+#include "libpekin_stm32_hal.h"
+#include "devices/control_timer.h"
+
+using namespace LibpStm32;
+
+// Timer counts in 100µs steps so the 16-bit ARR covers periods up to 6.5s
+static constexpr uint32_t tim_counts_per_ms = 10;
+
+static ControlTickFunc tick_func_ = nullptr;
+static uint32_t nominal_cycles_;
+static uint32_t cycles_per_us_;
+static uint32_t last_tick_cycles_;
+static bool first_tick_;
+static ControlTimerStats stats_;
+
+void initControlTimer(uint16_t period_ms, ControlTickFunc tick_func)
+{
+    tick_func_ = tick_func;
+
+    // DWT cycle counter for jitter/latency measurement
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    cycles_per_us_ = SystemCoreClock / 1'000'000;
+    nominal_cycles_ = SystemCoreClock / 1000 * period_ms;
+    first_tick_ = true;
+    resetControlTimerStats();
+
+    // APB1 timers run at 2x PCLK1 when the APB1 prescaler is not 1
+    Clk::enable<Clk::Apb1::tim7>();
+    uint32_t tim_clk = (RCC->CFGR & RCC_CFGR_PPRE1_2) ? Clk::getPClk1() * 2 : Clk::getPClk1();
+
+    TIM7->CR1 = 0;
+    TIM7->PSC = tim_clk / (1000 * tim_counts_per_ms) - 1;
+    TIM7->ARR = period_ms * tim_counts_per_ms - 1;
+    TIM7->EGR = TIM_EGR_UG; // load prescaler
+    TIM7->SR = 0;
+    TIM7->DIER = TIM_DIER_UIE;
+
+    NVIC_SetPriority(TIM7_IRQn, 2);
+    NVIC_EnableIRQ(TIM7_IRQn);
+    TIM7->CR1 = TIM_CR1_CEN;
+}
+
+ControlTimerStats getControlTimerStats()
+{
+    NVIC_DisableIRQ(TIM7_IRQn);
+    ControlTimerStats stats = stats_;
+    NVIC_EnableIRQ(TIM7_IRQn);
+    return stats;
+}
+
+void resetControlTimerStats()
+{
+    NVIC_DisableIRQ(TIM7_IRQn);
+    memset(&stats_, 0, sizeof(stats_));
+    NVIC_EnableIRQ(TIM7_IRQn);
+}
+
+static void recordJitter(uint32_t jitter_us)
+{
+    uint8_t bucket = 0;
+    while (bucket < control_jitter_buckets - 1 && jitter_us >= control_jitter_bucket_us[bucket])
+        bucket++;
+    stats_.jitter_hist[bucket]++;
+    if (jitter_us > stats_.max_jitter_us)
+        stats_.max_jitter_us = jitter_us;
+}
+
+extern "C"
+void TIM7_IRQHandler(void)
+{
+    if (!(TIM7->SR & TIM_SR_UIF))
+        return;
+    TIM7->SR = ~TIM_SR_UIF;
+
+    uint32_t start = DWT->CYCCNT;
+    if (!first_tick_) {
+        uint32_t period = start - last_tick_cycles_;
+        uint32_t deviation = period > nominal_cycles_
+                ? period - nominal_cycles_
+                : nominal_cycles_ - period;
+        recordJitter(deviation / cycles_per_us_);
+    }
+    first_tick_ = false;
+    last_tick_cycles_ = start;
+
+    if (tick_func_)
+        tick_func_();
+
+    uint32_t exec_cycles = DWT->CYCCNT - start;
+    uint32_t exec_us = exec_cycles / cycles_per_us_;
+    stats_.ticks++;
+    stats_.total_exec_us += exec_us;
+    if (exec_us > stats_.max_exec_us)
+        stats_.max_exec_us = exec_us;
+    if (exec_cycles > nominal_cycles_)
+        stats_.overruns++;
+}
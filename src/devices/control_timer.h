@@ -0,0 +1,51 @@
+/**
+ * Control loop timer functions.
+ *
+ * A hardware timer interrupt calls the oven control function at a fixed rate,
+ * independent of how long the UI loop takes to redraw. The interval between
+ * calls and the time spent in each call are measured with the DWT cycle
+ * counter and collected in a histogram.
+ */
+#ifndef SRC_DEVICES_CONTROL_TIMER_H_
+#define SRC_DEVICES_CONTROL_TIMER_H_
+
+#include <cstdint>
+
+/// Function called from the timer interrupt on each control tick.
+using ControlTickFunc = void (*)();
+
+/// Upper bound (exclusive) in µs of each jitter histogram bucket. The last
+/// bucket collects everything above.
+inline constexpr uint16_t control_jitter_bucket_us[] = { 10, 50, 100, 500, 1000, 5000 };
+inline constexpr uint8_t control_jitter_buckets = sizeof(control_jitter_bucket_us) / sizeof(uint16_t) + 1;
+
+struct ControlTimerStats {
+    /// Number of ticks measured
+    uint32_t ticks;
+    /// Count of ticks per |actual - nominal period| bucket
+    uint32_t jitter_hist[control_jitter_buckets];
+    uint32_t max_jitter_us;
+    /// Time spent in the tick function (latency to the output update)
+    uint32_t max_exec_us;
+    uint32_t total_exec_us;
+    /// Ticks where the tick function took longer than the period
+    uint32_t overruns;
+};
+
+/**
+ * Initialize and start the control timer (TIM7).
+ *
+ * @param period_ms interval between calls to @p tick_func. 1 -> 6553.
+ * @param tick_func called from interrupt context (priority 2)
+ */
+void initControlTimer(uint16_t period_ms, ControlTickFunc tick_func);
+
+/**
+ * Return a copy of the tick timing statistics collected since startup or the
+ * last call to @p resetControlTimerStats.
+ */
+ControlTimerStats getControlTimerStats();
+
+void resetControlTimerStats();
+
+#endif /* SRC_DEVICES_CONTROL_TIMER_H_ */
@@ -39,6 +39,7 @@ void initDoorServo()
             cycles_per_period,
             cycles_for_0_deg, // Or will 0 mean no movement? Preferred
             true);
+    timer_.enable();
 }
 
 void setDoorServo(uint16_t angle)
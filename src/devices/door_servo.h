@@ -6,11 +6,19 @@
 
 #include <cstdint>
 
+/**
+ * Servo angles for the closed and fully open door. These depend on how the
+ * servo horn and linkage are mounted and must be calibrated on the assembled
+ * oven: call @p setDoorServo with increasing angles and note the angle where
+ * the door just closes fully and the one where it stops opening further
+ * (before the linkage binds). The open angle is an uncalibrated default.
+ */
+inline constexpr uint8_t door_servo_closed_deg = 0;
+inline constexpr uint8_t door_servo_open_deg = 90;
+
 void initDoorServo();
 
+/// @param angle 0 -> 180
 void setDoorServo(uint16_t angle);
 
-
-
-
 #endif /* SRC_DEVICES_DOOR_SERVO_H_ */
@@ -1,24 +1,27 @@
 #include <cstdint>
 #include "clock_stm32f1xx.h"
-#include "timer_stm32f1xx.h"
+#include "libpekin_stm32_hal.h"
 #include "pins_stm32f1xx.h"
 #include "devices/peripherals.h"
+#include "devices/oven_ssr.h"
 
 using namespace LibpStm32;
 
-static constexpr uint32_t mcu_freq = 72'000'000; // TODO: get dynamically
-static constexpr uint8_t mains_freq = 60;
+static constexpr uint8_t default_mains_freq = 60;
+
+// Timer counts in 1µs steps, a half cycle (<= 10ms) fits the 16-bit ARR
+static constexpr uint32_t tim_counts_per_s = 1'000'000;
 
 // SSR is zero-crossing type so the shortest
 // duration it can be on/off is one half mains cycle
-static constexpr uint8_t crossing_freq = mains_freq * 2;
-static constexpr uint8_t power_steps = 100;
-static constexpr uint32_t tim_resolution = mcu_freq / crossing_freq;
-static constexpr uint32_t tim_period  = tim_resolution * power_steps;
-
+static volatile uint16_t tim_period_ = tim_counts_per_s / (default_mains_freq * 2);
 
-static const Tim::Channel tim_channel = Tim::Channel::ch1;
-static Tim::BasicTimer<TIM4_BASE> timer_;
+/// Requested power level percentage
+static volatile uint8_t power_ = 0;
+/// Sigma-delta accumulator, percent
+static uint8_t accum_ = 0;
+/// Output held off by forceOvenSsrOff
+static volatile bool forced_off_ = false;
 
 void initOvenSsr()
 {
@@ -31,22 +34,95 @@ void initOvenSsr()
 
     Clk::enable<Clk::Apb1::tim4>();
 
-    timer_.initPwm(
-            tim_channel,
-            tim_period,
-            0, // zero power out (off)
-            true);
-    timer_.enable();
+    // APB1 timers run at 2x PCLK1 when the APB1 prescaler is not 1
+    uint32_t tim_clk = (RCC->CFGR & RCC_CFGR_PPRE1_2) ? Clk::getPClk1() * 2 : Clk::getPClk1();
+
+    // PWM mode 1 with preloaded compare, so the on/off decision made in the
+    // update interrupt applies for the whole of the next half cycle
+    TIM4->CR1 = 0;
+    TIM4->PSC = tim_clk / tim_counts_per_s - 1;
+    TIM4->ARR = tim_period_ - 1;
+    TIM4->CCR1 = 0; // zero power out (off)
+    TIM4->CCMR1 = TIM_CCMR1_OC1M_2 | TIM_CCMR1_OC1M_1 | TIM_CCMR1_OC1PE;
+    TIM4->CCER = TIM_CCER_CC1E;
+    TIM4->EGR = TIM_EGR_UG; // load prescaler/compare
+    TIM4->SR = 0;
+    TIM4->DIER = TIM_DIER_UIE;
+
+    // Above the control timer so a busy control tick can't drop half cycles
+    NVIC_SetPriority(TIM4_IRQn, 1);
+    NVIC_EnableIRQ(TIM4_IRQn);
+    TIM4->CR1 = TIM_CR1_ARPE | TIM_CR1_CEN;
+}
+
+void setOvenSsrMainsFreq(uint8_t freq_hz)
+{
+    if (freq_hz < min_mains_freq || freq_hz > max_mains_freq)
+        return;
+    tim_period_ = tim_counts_per_s / (freq_hz * 2);
+    // Preloaded, takes effect from the next half cycle
+    TIM4->ARR = tim_period_ - 1;
 }
 
 void setOvenSsr(uint8_t power)
 {
-    // TODO: if power == 0, turn off timer/output
-    timer_.setCompare(tim_channel, power * tim_resolution);
+    if (forced_off_)
+        return;
+    power_ = power > 100 ? 100 : power;
+    if (power_ == 0)
+        TIM4->CCR1 = 0;
 }
 
 uint8_t getOvenSsr()
 {
-    // TODO: not working
-    return timer_.getCompare(tim_channel) / tim_resolution;
+    return forced_off_ ? 0 : power_;
+}
+
+void forceOvenSsrOff()
+{
+    // Output compare forced inactive, takes effect immediately
+    TIM4->CCMR1 = (TIM4->CCMR1 & ~TIM_CCMR1_OC1M) | TIM_CCMR1_OC1M_2;
+    forced_off_ = true;
+    power_ = 0;
+}
+
+void releaseOvenSsr()
+{
+    NVIC_DisableIRQ(TIM4_IRQn);
+    power_ = 0;
+    TIM4->CCR1 = 0;
+    TIM4->CCMR1 = (TIM4->CCMR1 & ~TIM_CCMR1_OC1M) | TIM_CCMR1_OC1M_2 | TIM_CCMR1_OC1M_1;
+    forced_off_ = false;
+    NVIC_EnableIRQ(TIM4_IRQn);
+}
+
+bool isOvenSsrForcedOff()
+{
+    return forced_off_;
+}
+
+/**
+ * First order sigma-delta modulator, one decision per half cycle. On half
+ * cycles are spread evenly (e.g. 30% = on, off, off, on, off, off, on, off,
+ * off, off) and the remainder carries over, so the delivered power matches
+ * the requested level exactly over any number of half cycles.
+ *
+ * The timer is not synchronized to the mains, the SSR itself switches at the
+ * next zero crossing.
+ */
+extern "C"
+void TIM4_IRQHandler(void)
+{
+    if (!(TIM4->SR & TIM_SR_UIF))
+        return;
+    TIM4->SR = ~TIM_SR_UIF;
+
+    accum_ += power_;
+    if (accum_ >= 100) {
+        accum_ -= 100;
+        TIM4->CCR1 = tim_period_; // > ARR = on for the whole period
+    }
+    else {
+        TIM4->CCR1 = 0;
+    }
 }
@@ -1,31 +1,63 @@
 /**
  * Oven SSR (solid state relay) hardware functions.
  *
- * Oven power is controlled via an SSR, which is in turn controlled via the PWM
- * output of the MCU.
+ * Oven power is controlled via an SSR, which is in turn controlled via a
+ * timer output of the MCU. The SSR switches at zero crossings, so power is
+ * delivered as whole mains half cycles, spread evenly by a sigma-delta
+ * modulator in the timer interrupt rather than as one on/off burst per
+ * PWM period.
  */
 #ifndef SRC_OVEN_SSR_H_
 #define SRC_OVEN_SSR_H_
 
 #include <cstdint>
 
+/// Supported mains frequency range in Hz
+inline constexpr uint8_t min_mains_freq = 45;
+inline constexpr uint8_t max_mains_freq = 65;
+
 /**
- * Initialize the oven SSR hardware.
+ * Initialize the oven SSR hardware for 60Hz mains. Timer clock derived from
+ * the current PCLK1 frequency.
  *
  * SSR will initially be off.
  */
 void initOvenSsr();
 
 /**
- * Set oven SSR output level.
+ * Set the mains frequency, so that each modulator step is exactly one half
+ * cycle. There's no zero crossing input so this cannot be measured.
+ *
+ * @param freq_hz @p min_mains_freq -> @p max_mains_freq, other values are
+ *                ignored
+ */
+void setOvenSsrMainsFreq(uint8_t freq_hz);
+
+/**
+ * Set oven SSR output level. Takes effect from the next half cycle.
  *
  * @param power 0 -> 100.
  */
 void setOvenSsr(uint8_t power);
 
 /**
- * Return the current oven SSR power level (0->100)
+ * Return the current oven SSR power level (0->100), as delivered on average
+ * by the modulator.
  */
 uint8_t getOvenSsr();
 
+/**
+ * Force the SSR output off in hardware, regardless of the power level, until
+ * @p releaseOvenSsr is called. Safe to call from any interrupt.
+ */
+void forceOvenSsrOff();
+
+/**
+ * Return the SSR output to the modulator after @p forceOvenSsrOff. The
+ * power level is reset to 0.
+ */
+void releaseOvenSsr();
+
+bool isOvenSsrForcedOff();
+
 #endif /* SRC_OVEN_SSR_H_ */
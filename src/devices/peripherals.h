@@ -77,6 +77,8 @@ inline constexpr uint8_t audio_out = 4;
 
 // SPI for MAX31856
 inline constexpr uint8_t max_spi_cs = 6;
+inline constexpr uint8_t max_drdy = 8;
+inline constexpr uint8_t max_fault = 7;
 
 // TFT LCD (ex FSMC)
 inline constexpr uint8_t im0 = 11;
@@ -3,7 +3,11 @@
 #include "drivers/max31856/max_31856.h"
 #include "serial/spi.h"
 #include "libpekin_stm32_hal.h"
+#include "libpekin.h"
 #include "devices/peripherals.h"
+#include "devices/thermocouple.h"
+#include "devices/oven_ssr.h"
+#include "oven/temp_estimator.h"
 
 using namespace Libp;
 using namespace LibpStm32;
@@ -38,22 +42,263 @@ static void initSpi()
             Spi::BitEndianess::msb_first);
 }
 
-void initThermocouple()
+// Latest conversion result, written only from the DRDY interrupt.
+// sample_seq_ is odd while an update is in progress (seqlock), which
+// allows lock free reads from lower priority contexts.
+static volatile uint32_t sample_seq_ = 0;
+static volatile int16_t sample_temp_ = 0;
+static volatile uint32_t sample_time_ms_ = 0;
+static volatile int32_t sample_est_temp_ = 0;
+static volatile int32_t sample_est_rate_ = 0;
+
+static TempEstimator estimator_;
+
+static constexpr Max31856::NoiseFilter noise_filter = Max31856::NoiseFilter::freq_50hz;
+// Continuous mode conversion time with the 50Hz filter (datasheet tCONV)
+static constexpr uint16_t first_conv_ms = 98;
+static constexpr uint16_t extra_conv_ms = 20;
+
+/// Averaging requested via setThermocoupleAveraging, applied from the DRDY
+/// interrupt as it is the only user of the bus once running
+static volatile uint8_t requested_averaging_ = default_tc_averaging;
+static uint8_t averaging_ = default_tc_averaging;
+
+static Max31856::ConversionMode toConversionMode(uint8_t samples)
+{
+    switch (samples) {
+    case 1:  return Max31856::ConversionMode::avg_1_sample;
+    case 2:  return Max31856::ConversionMode::avg_2_samples;
+    case 4:  return Max31856::ConversionMode::avg_4_samples;
+    case 16: return Max31856::ConversionMode::avg_16_samples;
+    case 8:
+    default: return Max31856::ConversionMode::avg_8_samples;
+    }
+}
+
+// Registers the driver doesn't cover, read/written with direct SPI2
+// transfers. Write address = read address | 0x80.
+static constexpr uint8_t reg_cr0 = 0x00;
+static constexpr uint8_t reg_mask = 0x02;
+static constexpr uint8_t reg_write = 0x80;
+/// CR0 OCFAULT = 01, open circuit detection for thermocouples below 5kΩ
+static constexpr uint8_t cr0_ocfault_01 = 0x10;
+static constexpr uint8_t cr0_ocfault_mask = 0x30;
+
+static uint8_t spiTransfer(uint8_t out)
+{
+    while (!(SPI2->SR & SPI_SR_TXE)) { }
+    SPI2->DR = out;
+    while (!(SPI2->SR & SPI_SR_RXNE)) { }
+    return SPI2->DR;
+}
+
+static uint8_t readRegister(uint8_t addr)
+{
+    (void)SPI2->DR; // discard anything left from the driver
+    setCs(true);
+    spiTransfer(addr);
+    uint8_t value = spiTransfer(0);
+    setCs(false);
+    return value;
+}
+
+static void writeRegister(uint8_t addr, uint8_t value)
+{
+    (void)SPI2->DR;
+    setCs(true);
+    spiTransfer(addr | reg_write);
+    spiTransfer(value);
+    setCs(false);
+}
+
+static void configure(uint8_t averaging)
 {
-    initSpi();
     max_ic.configure(
             Max31856::Mode::continuous,
             Max31856::TcType::k_type,
-            Max31856::ConversionMode::avg_8_samples,
-            Max31856::NoiseFilter::freq_50hz);
+            toConversionMode(averaging),
+            noise_filter);
+    // Open circuit detection is off at power up. Set after every configure
+    // in case the driver rewrites CR0.
+    uint8_t cr0 = readRegister(reg_cr0);
+    writeRegister(reg_cr0, (cr0 & ~cr0_ocfault_mask) | cr0_ocfault_01);
+}
+
+/**
+ * MASK powers up as 0xFF, every fault masked and FAULT never asserted.
+ * Unmask open circuit and over/under voltage; the TC and CJ range faults have
+ * no mask bit and always assert FAULT. The high/low threshold faults stay
+ * masked as the limits are left at their defaults. Mask bits match the
+ * fault status bits.
+ */
+static void configureFaultMask()
+{
+    writeRegister(reg_mask, TcFault::tc_low | TcFault::tc_high | TcFault::cj_low | TcFault::cj_high);
+}
+
+/// Read the conversion result over SPI, update the estimate and publish both.
+static void acquireSample()
+{
+    int16_t temp = Max31856::decodeTemp(max_ic.readTemp());
+    uint32_t now = Libp::getMillis();
+
+    // An averaged result represents the middle of the conversions
+    uint16_t latency_ms = (first_conv_ms + (averaging_ - 1) * extra_conv_ms) / 2;
+    uint32_t sample_time = now - latency_ms;
+    estimator_.addSample(temp, sample_time);
+    Q16 est_temp = estimator_.getTemp() + estimator_.getRate() * Q16::fromRatio(latency_ms, 1000);
+
+    sample_seq_ = sample_seq_ + 1;
+    sample_temp_ = temp;
+    sample_time_ms_ = sample_time;
+    sample_est_temp_ = est_temp.raw();
+    sample_est_rate_ = estimator_.getRate().raw();
+    sample_seq_ = sample_seq_ + 1;
+
+    // Conversion in progress continues with the old setting
+    if (requested_averaging_ != averaging_) {
+        averaging_ = requested_averaging_;
+        configure(averaging_);
+    }
+}
+
+/// Fault status read when FAULT was asserted, 0 = none
+static volatile uint8_t fault_status_ = 0;
+
+static bool isFaultAsserted()
+{
+    return !(GPIOC->IDR & (1 << PinNb::max_fault));
+}
+
+/// Turn the oven off first, then find out why.
+static void handleFault()
+{
+    forceOvenSsrOff();
+    uint8_t status = max_ic.readFaultStatus();
+    // Asserted but nothing reported, still treat as a fault
+    fault_status_ = fault_status_ | (status != 0 ? status : TcFault::tc_range);
+}
+
+static void initFaultInt()
+{
+    // FAULT is open drain, active low. Input with pull-up (CNF=10, ODR=1).
+    GPIOC->CRL = (GPIOC->CRL & ~(0xFu << (PinNb::max_fault * 4))) | (0x8u << (PinNb::max_fault * 4));
+    GPIOC->BSRR = 1 << PinNb::max_fault;
+    Clk::enable<Clk::Apb2::afio>();
+
+    AFIO->EXTICR[1] = (AFIO->EXTICR[1] & ~AFIO_EXTICR2_EXTI7) | AFIO_EXTICR2_EXTI7_PC;
+    EXTI->FTSR |= EXTI_FTSR_TR7;
+    EXTI->RTSR &= ~EXTI_RTSR_TR7;
+    EXTI->PR = EXTI_PR_PR7;
+    EXTI->IMR |= EXTI_IMR_MR7;
+
+    // Already asserted, no edge will arrive
+    if (isFaultAsserted())
+        handleFault();
+}
+
+static void initDrdyInt()
+{
+    // DRDY is active low and returns high once the temperature
+    // registers have been read, so trigger on the falling edge.
+    GpioC::setInputs<InputMode::floating, PinNb::max_drdy>();
+    Clk::enable<Clk::Apb2::afio>();
+
+    AFIO->EXTICR[2] = (AFIO->EXTICR[2] & ~AFIO_EXTICR3_EXTI8) | AFIO_EXTICR3_EXTI8_PC;
+    EXTI->FTSR |= EXTI_FTSR_TR8;
+    EXTI->RTSR &= ~EXTI_RTSR_TR8;
+    EXTI->PR = EXTI_PR_PR8;
+    EXTI->IMR |= EXTI_IMR_MR8;
+
+    // Below the display DMA, but above anything that reads the sample.
+    // Shared with the FAULT interrupt (EXTI7).
+    NVIC_SetPriority(EXTI9_5_IRQn, 1);
+    NVIC_EnableIRQ(EXTI9_5_IRQn);
+}
+
+void initThermocouple()
+{
+    initSpi();
+    configure(averaging_);
 
     // gradient between ref. junction and IC sensor
     max_ic.setCjOffset(-1.5 / 0.0625);
+    configureFaultMask();
+
+    // Read once to release DRDY in case a conversion completed before the
+    // interrupt was enabled (no further falling edge would arrive).
+    acquireSample();
+    initFaultInt();
+    initDrdyInt();
+}
+
+uint8_t getThermocoupleFault()
+{
+    return fault_status_;
+}
+
+bool clearThermocoupleFault()
+{
+    // A fault arriving part way through is handled once re-enabled
+    NVIC_DisableIRQ(EXTI9_5_IRQn);
+    bool cleared = !isFaultAsserted();
+    if (cleared) {
+        fault_status_ = 0;
+        releaseOvenSsr();
+    }
+    NVIC_EnableIRQ(EXTI9_5_IRQn);
+    return cleared;
+}
+
+const char* getThermocoupleFaultText(uint8_t status)
+{
+    if (status & TcFault::open_circuit)       return "Thermocouple open circuit";
+    if (status & TcFault::over_under_voltage) return "Thermocouple short/over voltage";
+    if (status & TcFault::tc_range)           return "Thermocouple out of range";
+    if (status & TcFault::cj_range)           return "Cold junction out of range";
+    if (status & (TcFault::tc_low | TcFault::tc_high)) return "Thermocouple temp. limit";
+    if (status & (TcFault::cj_low | TcFault::cj_high)) return "Cold junction temp. limit";
+    return "No fault";
+}
+
+void setThermocoupleAveraging(uint8_t samples)
+{
+    requested_averaging_ = samples >= 16 ? 16
+            : samples >= 8 ? 8
+            : samples >= 4 ? 4
+            : samples >= 2 ? 2 : 1;
+}
+
+TempSample getTempSample()
+{
+    TempSample sample;
+    uint32_t seq;
+    do {
+        seq = sample_seq_;
+        sample.temp = sample_temp_;
+        sample.timestamp_ms = sample_time_ms_;
+        sample.est_temp = Q16::fromRaw(sample_est_temp_);
+        sample.est_rate = Q16::fromRaw(sample_est_rate_);
+    } while ((seq & 1) || seq != sample_seq_);
+    return sample;
 }
 
 int16_t readTemp()
 {
-    uint32_t raw_temp = max_ic.readTemp();
-    return Max31856::decodeTemp(raw_temp);
+    return getTempSample().temp;
+}
+
+extern "C"
+void EXTI9_5_IRQHandler(void)
+{
+    // Fault first, so the SSR is off before spending time on a sample
+    if (EXTI->PR & EXTI_PR_PR7) {
+        EXTI->PR = EXTI_PR_PR7;
+        handleFault();
+    }
+    if (EXTI->PR & EXTI_PR_PR8) {
+        EXTI->PR = EXTI_PR_PR8;
+        acquireSample();
+    }
 }
 
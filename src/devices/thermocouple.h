@@ -2,19 +2,94 @@
  * Thermocouple hardware functions.
  *
  * The thermocouple is connected to a MAX31856, which is read via SPI.
+ *
+ * The MAX31856 runs in continuous conversion mode. Each conversion is read
+ * exactly once from the DRDY interrupt, passed through the temperature/rate
+ * estimator and cached, so readers never touch the SPI bus.
  */
 #ifndef SRC_DEVICES_THERMOCOUPLE_H_
 #define SRC_DEVICES_THERMOCOUPLE_H_
 
 #include <cstdint>
+#include "fixed_point.h"
 
 /**
  * Initialize thermocouple hawdware.
  */
 void initThermocouple();
 
+/// Conversions averaged per result by default (1, 2, 4, 8 or 16)
+inline constexpr uint8_t default_tc_averaging = 8;
+
+/// A single thermocouple conversion result.
+struct TempSample {
+    /// Temperature in tenths of a degree Celcius.
+    int16_t temp;
+    /// @p Libp::getMillis() time the temperature applies to, i.e. when the
+    /// conversion was read less half the (averaged) conversion time.
+    uint32_t timestamp_ms;
+    /// Temperature estimated from this and previous conversions, at the
+    /// time the conversion was read (0.1°C), see @p TempEstimator
+    Q16 est_temp;
+    /// Estimated rate of change in 0.1°C/s
+    Q16 est_rate;
+};
+
+/**
+ * Set the number of conversions averaged per result. More averaging reduces
+ * noise at the cost of latency (~100ms + 20ms per extra conversion at
+ * 50Hz). Applied by the DRDY interrupt after the next result is read.
+ *
+ * @param samples 1, 2, 4, 8 or 16, other values are rounded down
+ */
+void setThermocoupleAveraging(uint8_t samples);
+
+/// MAX31856 fault status register bits
+namespace TcFault {
+inline constexpr uint8_t open_circuit = 0x01;
+inline constexpr uint8_t over_under_voltage = 0x02;
+inline constexpr uint8_t tc_low = 0x04;
+inline constexpr uint8_t tc_high = 0x08;
+inline constexpr uint8_t cj_low = 0x10;
+inline constexpr uint8_t cj_high = 0x20;
+inline constexpr uint8_t tc_range = 0x40;
+inline constexpr uint8_t cj_range = 0x80;
+}
+
+/**
+ * Return the fault status latched when the MAX31856 FAULT output was
+ * asserted. The FAULT interrupt forces the SSR off (@p forceOvenSsrOff) before
+ * reading the status, so the oven stays off until @p clearThermocoupleFault.
+ *
+ * @return @p TcFault bits, 0 if no fault has occurred
+ */
+uint8_t getThermocoupleFault();
+
+/**
+ * Clear the latched fault and release the SSR, unless the FAULT output is
+ * still asserted.
+ *
+ * @return false if the fault is still present
+ */
+bool clearThermocoupleFault();
+
+/**
+ * @param status @p TcFault bits
+ *
+ * @return description of the most significant fault
+ */
+const char* getThermocoupleFaultText(uint8_t status);
+
+/**
+ * Return the most recent conversion result. Does not access the bus.
+ *
+ * Must not be called from an interrupt with higher priority than the DRDY
+ * interrupt.
+ */
+TempSample getTempSample();
+
 /**
- * Read thermocouple temperature
+ * Return the most recent thermocouple temperature. Does not access the bus.
  *
  * @return temperature in tenths of a degree Celcius.
  */
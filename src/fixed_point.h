@@ -0,0 +1,103 @@
+#ifndef SRC_FIXED_POINT_H_
+#define SRC_FIXED_POINT_H_
+
+#include <cstdint>
+#include <type_traits>
+
+/**
+ * Signed Q-format fixed point number with @p frac_bits fractional bits stored
+ * in 32 bits.
+ *
+ * The MCU has no FPU, so this is used in place of float on the control and
+ * chart paths. Addition, subtraction and multiplication/division by an integer
+ * are single instructions on the Cortex-M3. Multiplication by another fixed
+ * point value uses a 32x32->64 multiply. Only division by another fixed point
+ * value (and @p fromRatio) requires a 64-bit division.
+ *
+ * Construction from an integer is implicit, construction from a floating
+ * point type is not possible, other than via @p fromFloat for compile time
+ * constants.
+ */
+template <uint8_t frac_bits>
+class Fixed {
+public:
+    static_assert(frac_bits > 0 && frac_bits < 31);
+
+    constexpr Fixed() : raw_(0) { }
+
+    template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
+    constexpr Fixed(T value) : raw_(static_cast<int32_t>(value) * one) { }
+
+    static constexpr Fixed fromRaw(int32_t raw)
+    {
+        Fixed f;
+        f.raw_ = raw;
+        return f;
+    }
+
+    /// Return @p num / @p den
+    static constexpr Fixed fromRatio(int32_t num, int32_t den)
+    {
+        return fromRaw((static_cast<int64_t>(num) << frac_bits) / den);
+    }
+
+    /// For compile time constants only.
+    static constexpr Fixed fromFloat(double value)
+    {
+        return fromRaw(static_cast<int32_t>(value * one + (value < 0 ? -0.5 : 0.5)));
+    }
+
+    constexpr int32_t raw() const { return raw_; }
+
+    /// Round towards negative infinity
+    constexpr int32_t floor() const { return raw_ >> frac_bits; }
+
+    /// Round to nearest
+    constexpr int32_t round() const { return (raw_ + half) >> frac_bits; }
+
+    constexpr Fixed clamp(Fixed lo, Fixed hi) const
+    {
+        return *this < lo ? lo : (*this > hi ? hi : *this);
+    }
+
+    constexpr Fixed operator-() const { return fromRaw(-raw_); }
+
+    constexpr Fixed& operator+=(Fixed rhs) { raw_ += rhs.raw_; return *this; }
+    constexpr Fixed& operator-=(Fixed rhs) { raw_ -= rhs.raw_; return *this; }
+
+    friend constexpr Fixed operator+(Fixed lhs, Fixed rhs) { return fromRaw(lhs.raw_ + rhs.raw_); }
+    friend constexpr Fixed operator-(Fixed lhs, Fixed rhs) { return fromRaw(lhs.raw_ - rhs.raw_); }
+
+    friend constexpr Fixed operator*(Fixed lhs, Fixed rhs)
+    {
+        return fromRaw((static_cast<int64_t>(lhs.raw_) * rhs.raw_) >> frac_bits);
+    }
+    friend constexpr Fixed operator/(Fixed lhs, Fixed rhs)
+    {
+        return fromRaw((static_cast<int64_t>(lhs.raw_) << frac_bits) / rhs.raw_);
+    }
+
+    // Integer operands avoid the 64-bit intermediate. Caller must ensure the
+    // result fits in the 32-bit raw value.
+    friend constexpr Fixed operator*(Fixed lhs, int32_t rhs) { return fromRaw(lhs.raw_ * rhs); }
+    friend constexpr Fixed operator*(int32_t lhs, Fixed rhs) { return fromRaw(lhs * rhs.raw_); }
+    friend constexpr Fixed operator/(Fixed lhs, int32_t rhs) { return fromRaw(lhs.raw_ / rhs); }
+
+    friend constexpr bool operator==(Fixed lhs, Fixed rhs) { return lhs.raw_ == rhs.raw_; }
+    friend constexpr bool operator!=(Fixed lhs, Fixed rhs) { return lhs.raw_ != rhs.raw_; }
+    friend constexpr bool operator< (Fixed lhs, Fixed rhs) { return lhs.raw_ <  rhs.raw_; }
+    friend constexpr bool operator> (Fixed lhs, Fixed rhs) { return lhs.raw_ >  rhs.raw_; }
+    friend constexpr bool operator<=(Fixed lhs, Fixed rhs) { return lhs.raw_ <= rhs.raw_; }
+    friend constexpr bool operator>=(Fixed lhs, Fixed rhs) { return lhs.raw_ >= rhs.raw_; }
+
+private:
+    static constexpr int32_t one = static_cast<int32_t>(1) << frac_bits;
+    static constexpr int32_t half = one >> 1;
+
+    int32_t raw_;
+};
+
+/// Q15.16 - general purpose (range ±32767, resolution ~0.000015)
+using Q16 = Fixed<16>;
+
+#endif /* SRC_FIXED_POINT_H_ */
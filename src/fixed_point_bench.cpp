@@ -0,0 +1,86 @@
+#include "fixed_point_bench.h"
+
+#if RUN_FIXED_POINT_BENCH
+#include <cstdint>
+#include <algorithm>
+#include <pid/pid_algo.h>
+#include "libpekin_stm32_hal.h"
+#include "oven/pid_ctrl.h"
+#include "oven/oven_model.h"
+#include "error_handler.h"
+
+static volatile int32_t bench_sink_;
+static uint64_t bench_millis_ = 0;
+static uint64_t getBenchMillis() { return bench_millis_ += 1000; }
+
+/// Return average cycles per call of @p func over @p n calls
+template <typename F>
+static uint32_t benchCycles(uint16_t n, F func)
+{
+    uint32_t start = DWT->CYCCNT;
+    for (uint16_t i = 0; i < n; i++)
+        func(i);
+    return (DWT->CYCCNT - start) / n;
+}
+
+void runFixedPointBench()
+{
+    static constexpr uint16_t n = 1000;
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    // PID update (libpekin float PidAlgo vs PidCtrl)
+
+    static Libp::PidAlgo pid_float(40, 10, 5, 0, 100, getBenchMillis);
+    pid_float.init(500, 1, Libp::PidAlgo::Mode::gradient);
+    uint32_t pid_float_cycles = benchCycles(n, [](uint16_t i) {
+        float out;
+        pid_float.compute(15, 500 + i % 200, &out);
+        bench_sink_ = out;
+    });
+    static PidCtrl pid_fixed(40, 10, 5, 0, 100, getBenchMillis);
+    pid_fixed.init(500, 1000, PidCtrl::Mode::gradient);
+    uint32_t pid_fixed_cycles = benchCycles(n, [](uint16_t i) {
+        Q16 out;
+        pid_fixed.compute(15, 500 + i % 200, &out);
+        bench_sink_ = out.round();
+    });
+
+    // Chart point scaling (reflow run page)
+
+    static constexpr uint16_t chart_h = 230;
+    static constexpr uint16_t chart_w = 460;
+    static constexpr uint16_t duration = 250;
+    static constexpr uint16_t max_temp = 2350;
+    uint32_t chart_float_cycles = benchCycles(n, [](uint16_t i) {
+        float x_ratio = (float)chart_w / duration;
+        float y_ratio = (float)chart_h / max_temp;
+        bench_sink_ = (int16_t)(x_ratio * (i % duration)) + (int16_t)(chart_h - (500 + i) * y_ratio);
+    });
+    uint32_t chart_fixed_cycles = benchCycles(n, [](uint16_t i) {
+        Q16 x_ratio = Q16::fromRatio(chart_w, duration);
+        Q16 y_ratio = Q16::fromRatio(chart_h, max_temp);
+        bench_sink_ = (x_ratio * (i % duration)).floor() + chart_h - (y_ratio * (500 + i)).floor();
+    });
+
+    // Oven model step (previous float oven_sim.h formula)
+
+    uint32_t model_float_cycles = benchCycles(n, [](uint16_t i) {
+        float temp_diff = i;
+        float power = i % 100;
+        float cool_dtds = -.002115f * temp_diff + .6675f;
+        float heat_dtds = -.0015f * temp_diff + 25;
+        heat_dtds *= power / 100 * (power * .002f + .80f);
+        heat_dtds = std::min(heat_dtds, 25.f);
+        bench_sink_ = (cool_dtds + heat_dtds) * 1000 / 1000;
+    });
+    uint32_t model_fixed_cycles = benchCycles(n, [](uint16_t i) {
+        bench_sink_ = default_oven_model.calcDtDs(Q16(i), Q16(i % 100), 0, 1000).raw();
+    });
+
+    getErrHndlr().report("cycles/call float,fixed: pid %d,%d chart %d,%d model %d,%d\r\n",
+            (int)pid_float_cycles, (int)pid_fixed_cycles,
+            (int)chart_float_cycles, (int)chart_fixed_cycles,
+            (int)model_float_cycles, (int)model_fixed_cycles);
+}
+#endif
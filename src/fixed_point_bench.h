@@ -0,0 +1,13 @@
+/**
+ * Compares cycle counts of the fixed point control/chart math against the
+ * equivalent soft-float implementations. Output via UART.
+ */
+#ifndef SRC_FIXED_POINT_BENCH_H_
+#define SRC_FIXED_POINT_BENCH_H_
+
+// Run the benchmark on startup
+#define RUN_FIXED_POINT_BENCH 0
+
+void runFixedPointBench();
+
+#endif /* SRC_FIXED_POINT_BENCH_H_ */
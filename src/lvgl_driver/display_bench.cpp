@@ -0,0 +1,29 @@
+#include "lvgl_driver/display_bench.h"
+
+#if RUN_DISPLAY_BENCH
+#include <cstdint>
+#include "lvgl/lvgl.h"
+#include "libpekin_stm32_hal.h"
+#include "error_handler.h"
+
+void runDisplayBench()
+{
+    static constexpr uint8_t n = 10;
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    lv_disp_t* disp = lv_disp_get_default();
+    uint32_t start = DWT->CYCCNT;
+    for (uint8_t i = 0; i < n; i++) {
+        lv_obj_invalidate(lv_scr_act());
+        lv_refr_now(disp);
+        // Last stripe may still be transferring
+        while (lv_disp_get_buf(disp)->flushing) { }
+    }
+    uint32_t us = (DWT->CYCCNT - start) / (SystemCoreClock / 1'000'000) / n;
+
+    getErrHndlr().report("full screen redraw %dus (%d buffer(s) of %d rows)\r\n",
+            (int)us, lv_disp_is_double_buf(disp) ? 2 : 1,
+            (int)(lv_disp_get_buf(disp)->size / lv_disp_get_hor_res(disp)));
+}
+#endif
@@ -0,0 +1,12 @@
+/**
+ * Times full screen redraws of the current screen. Output via UART.
+ */
+#ifndef SRC_LVGL_DRIVER_DISPLAY_BENCH_H_
+#define SRC_LVGL_DRIVER_DISPLAY_BENCH_H_
+
+// Run the benchmark on startup, after the UI is built
+#define RUN_DISPLAY_BENCH 0
+
+void runDisplayBench();
+
+#endif /* SRC_LVGL_DRIVER_DISPLAY_BENCH_H_ */
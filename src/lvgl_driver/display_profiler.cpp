@@ -0,0 +1,145 @@
+#include "lvgl_driver/display_profiler.h"
+
+#if PROFILE_DISPLAY
+#include <cstring>
+#include <cstdio>
+#include "libpekin.h"
+#include "libpekin_stm32_hal.h"
+#include "error_handler.h"
+
+/// A flush this soon after the previous transfer completed was waiting for it
+static constexpr uint32_t dma_wait_detect_us = 5;
+
+static uint32_t cycles_per_us_;
+static DisplayProfile profile_;
+
+static uint32_t flush_start_;
+static uint32_t flush_return_;
+static volatile uint32_t flush_done_;
+static uint32_t flush_px_;
+/// No previous area in this refresh to measure from
+static bool first_area_ = true;
+static uint32_t handler_start_;
+
+void initDisplayProfiler()
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    cycles_per_us_ = SystemCoreClock / 1'000'000;
+    first_area_ = true;
+    resetDisplayProfile();
+}
+
+DisplayProfile getDisplayProfile()
+{
+    NVIC_DisableIRQ(DMA1_Channel1_IRQn);
+    DisplayProfile profile = profile_;
+    NVIC_EnableIRQ(DMA1_Channel1_IRQn);
+    return profile;
+}
+
+void resetDisplayProfile()
+{
+    NVIC_DisableIRQ(DMA1_Channel1_IRQn);
+    memset(&profile_, 0, sizeof(profile_));
+    NVIC_EnableIRQ(DMA1_Channel1_IRQn);
+}
+
+void profileTaskHandlerStart()
+{
+    handler_start_ = DWT->CYCCNT;
+}
+
+void profileTaskHandlerEnd()
+{
+    profile_.handler_us += (DWT->CYCCNT - handler_start_) / cycles_per_us_;
+}
+
+void profileFlushStart(const lv_area_t* area, bool double_buf)
+{
+    uint32_t now = DWT->CYCCNT;
+    // LVGL only flushes once the previous transfer is done
+    uint32_t prev_done = flush_done_;
+
+    if (!first_area_) {
+        uint32_t render_start = double_buf ? flush_return_ : prev_done;
+        if (double_buf && now - prev_done < dma_wait_detect_us * cycles_per_us_) {
+            profile_.dma_waits++;
+        }
+        else {
+            uint32_t render_us = (now - render_start) / cycles_per_us_;
+            profile_.rendered_areas++;
+            profile_.render_us += render_us;
+            if (render_us > profile_.max_render_us)
+                profile_.max_render_us = render_us;
+        }
+    }
+    first_area_ = false;
+
+    flush_px_ = static_cast<uint32_t>(area->x2 - area->x1 + 1) * (area->y2 - area->y1 + 1);
+    flush_start_ = now;
+}
+
+void profileFlushReturn()
+{
+    flush_return_ = DWT->CYCCNT;
+}
+
+void profileFlushDone()
+{
+    uint32_t now = DWT->CYCCNT;
+    flush_done_ = now;
+    profile_.flushes++;
+    profile_.pixels += flush_px_;
+    if (flush_px_ > profile_.max_flush_pixels)
+        profile_.max_flush_pixels = flush_px_;
+    profile_.transfer_us += (now - flush_start_) / cycles_per_us_;
+}
+
+extern "C"
+void displayProfilerMonitor(lv_disp_drv_t*, uint32_t time_ms, uint32_t)
+{
+    profile_.refreshes++;
+    profile_.refresh_ms += time_ms;
+    first_area_ = true;
+}
+
+static lv_obj_t* profile_label_ = nullptr;
+
+void outputDisplayProfile()
+{
+    if (profile_label_ == nullptr) {
+        profile_label_ = lv_label_create(lv_layer_top(), NULL);
+        lv_label_set_text(profile_label_, "");
+        lv_obj_align(profile_label_, NULL, LV_ALIGN_IN_BOTTOM_LEFT, 0, 0);
+    }
+
+    static uint32_t last = 0;
+    uint32_t now = Libp::getMillis();
+    uint32_t elapsed_ms = now - last;
+    if (elapsed_ms < 1000)
+        return;
+    last = now;
+
+    DisplayProfile p = getDisplayProfile();
+    resetDisplayProfile();
+    // Bytes per µs = MB/s
+    uint32_t mbps_x10 = p.transfer_us ? p.pixels * sizeof(lv_color_t) * 10 / p.transfer_us : 0;
+    uint32_t fps_x10 = p.refreshes * 10000 / elapsed_ms;
+    uint32_t render_us = p.rendered_areas ? p.render_us / p.rendered_areas : 0;
+
+    getErrHndlr().report("display fps=%d.%d refresh=%dms flushes=%d px=%d max_px=%d"
+            " xfer=%dus %d.%dMB/s render=%dus/area max=%dus dma_waits=%d handler=%dus\r\n",
+            (int)(fps_x10 / 10), (int)(fps_x10 % 10),
+            (int)(p.refreshes ? p.refresh_ms / p.refreshes : 0),
+            (int)p.flushes, (int)(p.flushes ? p.pixels / p.flushes : 0), (int)p.max_flush_pixels,
+            (int)p.transfer_us, (int)(mbps_x10 / 10), (int)(mbps_x10 % 10),
+            (int)render_us, (int)p.max_render_us, (int)p.dma_waits, (int)p.handler_us);
+
+    char text[sizeof("999.9 fps  99.9 MB/s  render 999999us  waits 99999/99999")];
+    snprintf(text, sizeof(text), "%d.%d fps  %d.%d MB/s  render %dus  waits %d/%d",
+            (int)(fps_x10 / 10), (int)(fps_x10 % 10), (int)(mbps_x10 / 10), (int)(mbps_x10 % 10),
+            (int)render_us, (int)p.dma_waits, (int)p.flushes);
+    lv_label_set_text(profile_label_, text);
+}
+#endif
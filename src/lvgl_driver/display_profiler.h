@@ -0,0 +1,82 @@
+/**
+ * Display pipeline profiler.
+ *
+ * The flush callback, the DMA complete interrupt and the main loop timestamp
+ * each stripe with the DWT cycle counter: when LVGL hands it over, when the
+ * DMA transfer to the FSMC finishes and how long @p lv_task_handler runs.
+ *
+ * Render time of an area is measured from the point LVGL was free to start it
+ * to its flush. With one draw buffer that is the end of the previous
+ * transfer, so render time is exact and the transfer time is all waiting.
+ * With ping-pong buffers rendering starts as soon as the previous flush call
+ * returns, but an area finished while that transfer is still running waits
+ * for it and only the sum is known. Those areas are counted in @p dma_waits
+ * and left out of the render time; many of them means the display transfer,
+ * not rendering, limits the frame rate.
+ *
+ * The first area of each refresh has no start point and is not timed.
+ */
+#ifndef SRC_LVGL_DRIVER_DISPLAY_PROFILER_H_
+#define SRC_LVGL_DRIVER_DISPLAY_PROFILER_H_
+
+#include <cstdint>
+#include "lvgl/lvgl.h"
+
+// Collect display timings, output via UART and an overlay every second
+#define PROFILE_DISPLAY 0
+
+struct DisplayProfile {
+    uint32_t flushes;
+    uint32_t pixels;
+    uint32_t max_flush_pixels;
+    /// From the flush call to the DMA complete interrupt
+    uint32_t transfer_us;
+    /// Areas with a known render time
+    uint32_t rendered_areas;
+    uint32_t render_us;
+    uint32_t max_render_us;
+    /// Areas rendered before the previous transfer completed (two buffers)
+    uint32_t dma_waits;
+    /// Completed refreshes and their total time reported by LVGL
+    uint32_t refreshes;
+    uint32_t refresh_ms;
+    /// Time in lv_task_handler, rendering, waiting and everything else
+    uint32_t handler_us;
+};
+
+/// Enable the DWT cycle counter and clear the totals
+void initDisplayProfiler();
+
+/**
+ * Return a copy of the totals collected since @p initDisplayProfiler or the
+ * last call to @p resetDisplayProfile.
+ */
+DisplayProfile getDisplayProfile();
+
+void resetDisplayProfile();
+
+/**
+ * Output the totals via UART and in an overlay on the top layer once a second,
+ * then reset them. Call from the main loop.
+ *
+ * Updating the overlay causes a small refresh itself, so the frame rate
+ * doesn't drop below one per second.
+ */
+void outputDisplayProfile();
+
+/// Bracket each call to lv_task_handler
+void profileTaskHandlerStart();
+void profileTaskHandlerEnd();
+
+/// Called by the display driver at the start and end of each flush call
+void profileFlushStart(const lv_area_t* area, bool double_buf);
+void profileFlushReturn();
+
+/// Called from the DMA complete interrupt
+void profileFlushDone();
+
+/// LVGL @p monitor_cb, called after each refresh
+extern "C"
+void displayProfilerMonitor(lv_disp_drv_t* disp_drv, uint32_t time_ms, uint32_t px);
+
+#endif /* SRC_LVGL_DRIVER_DISPLAY_PROFILER_H_ */
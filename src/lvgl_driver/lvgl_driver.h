@@ -4,12 +4,26 @@
 #include "main.h"
 #include "lvgl/lvgl.h"
 #include <lvgl_driver/lvgl_tft_driver.h>
+#include <lvgl_driver/lvgl_gpu_driver.h>
 #include <graphics/idrawing_surface.h>
 #include <lvgl_driver/lvgl_touch_driver.h>
+#include <lvgl_driver/display_profiler.h>
 
-static constexpr uint16_t buffer_size = App::ui_width * 40;
+/// Rows rendered before flushing, split between the draw buffers. Together
+/// with the LVGL heap this is most of the RAM on the 64KB part, so fewer rows
+/// are needed if @p LV_MEM_SIZE is increased.
+static constexpr uint16_t display_buf_rows = 40;
+/// 2 = ping-pong buffers, the next stripe renders while DMA transfers the
+/// previous one to the display. 1 = LVGL waits for each transfer.
+static constexpr uint8_t display_buf_count = 2;
+/// LVGL heap and draw buffers
+static constexpr uint32_t display_ram_budget = 56U * 1024U;
+
+static_assert(display_buf_count == 1 || display_buf_count == 2);
+static constexpr uint16_t buffer_size = App::ui_width * (display_buf_rows / display_buf_count);
 static lv_disp_buf_t disp_buf;
-static lv_color_t rows_buf[buffer_size];
+static lv_color_t rows_buf[display_buf_count][buffer_size];
+static_assert(sizeof(rows_buf) + LV_MEM_SIZE <= display_ram_budget);
 
 /**
  * Setup LVGL touch and display drivers. Provided references will be stored in
@@ -21,7 +35,7 @@ static lv_color_t rows_buf[buffer_size];
 inline
 void initLvglHalDrivers(Libp::ResistiveTouch::Screen* touch_screen, Libp::IDrawingSurface<uint16_t>* display)
 {
-    lv_disp_buf_init(&disp_buf, rows_buf, NULL, buffer_size);
+    lv_disp_buf_init(&disp_buf, rows_buf[0], display_buf_count == 2 ? rows_buf[display_buf_count - 1] : NULL, buffer_size);
 
     // display driver
 
@@ -31,7 +45,14 @@ void initLvglHalDrivers(Libp::ResistiveTouch::Screen* touch_screen, Libp::IDrawi
     disp_drv.ver_res = App::ui_height;
     disp_drv.buffer = &disp_buf;
     disp_drv.flush_cb = lvgl_tftdriver_flush_dma;
+    initLvglGpuDriver();
+    disp_drv.gpu_fill_cb = lvgl_gpudriver_fill;
+    disp_drv.gpu_blend_cb = lvgl_gpudriver_blend;
     disp_drv.user_data = static_cast<void*>(display);
+#if PROFILE_DISPLAY
+    initDisplayProfiler();
+    disp_drv.monitor_cb = displayProfilerMonitor;
+#endif
     lv_disp_drv_register(&disp_drv);
 
     // touch input driver
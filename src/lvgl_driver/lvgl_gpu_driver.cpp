@@ -0,0 +1,107 @@
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include "clock_stm32f1xx.h"
+#include "libpekin_stm32_hal.h"
+#include "lvgl_driver/lvgl_gpu_driver.h"
+#include "error_handler.h"
+
+using namespace LibpStm32;
+
+static_assert(LV_COLOR_DEPTH == 16);
+
+/// Shorter runs are filled by the CPU, setting up a transfer costs more
+static constexpr uint16_t dma_fill_min_px = 32;
+
+/// Fixed transfer source, the colour twice so each transfer writes two pixels
+static volatile uint32_t fill_color_;
+
+void initLvglGpuDriver()
+{
+    Clk::enable<Clk::Ahb::dma1>();
+    DMA1_Channel2->CCR = 0;
+}
+
+/// Fill @p words 32-bit words at @p dest with @p fill_color_
+static void dmaFill(uint32_t* dest, uint32_t words)
+{
+    while (words > 0) {
+        uint16_t n = std::min<uint32_t>(words, UINT16_MAX);
+        // Memory to memory, read from CMAR (not incremented) and write to
+        // CPAR (incremented)
+        DMA1_Channel2->CCR = 0;
+        DMA1_Channel2->CPAR = reinterpret_cast<uint32_t>(dest);
+        DMA1_Channel2->CMAR = reinterpret_cast<uint32_t>(&fill_color_);
+        DMA1_Channel2->CNDTR = n;
+        DMA1->IFCR = DMA_IFCR_CGIF2;
+        DMA1_Channel2->CCR = DMA_CCR_MEM2MEM | DMA_CCR_DIR | DMA_CCR_PINC
+                | DMA_CCR_PSIZE_1 | DMA_CCR_MSIZE_1 | DMA_CCR_EN;
+        while (!(DMA1->ISR & (DMA_ISR_TCIF2 | DMA_ISR_TEIF2))) { }
+        DMA1_Channel2->CCR = 0;
+        if (DMA1->ISR & DMA_ISR_TEIF2)
+            getErrHndlr().halt(ErrCode::dma);
+        dest += n;
+        words -= n;
+    }
+}
+
+static void fillRun(uint16_t* dest, uint32_t len, uint16_t color)
+{
+    if (len < dma_fill_min_px) {
+        while (len-- > 0)
+            *dest++ = color;
+        return;
+    }
+    if (reinterpret_cast<uintptr_t>(dest) & 2) {
+        *dest++ = color;
+        len--;
+    }
+    dmaFill(reinterpret_cast<uint32_t*>(dest), len / 2);
+    if (len & 1)
+        dest[len - 1] = color;
+}
+
+extern "C"
+void lvgl_gpudriver_fill(lv_disp_drv_t *, lv_color_t * dest_buf, lv_coord_t dest_width,
+        const lv_area_t * fill_area, lv_color_t color)
+{
+    fill_color_ = color.full | static_cast<uint32_t>(color.full) << 16;
+    uint16_t w = lv_area_get_width(fill_area);
+    uint16_t h = lv_area_get_height(fill_area);
+    uint16_t* dest = reinterpret_cast<uint16_t*>(dest_buf) + fill_area->y1 * dest_width + fill_area->x1;
+
+    // Full width rows are contiguous, one run for the whole area
+    if (w == dest_width) {
+        fillRun(dest, static_cast<uint32_t>(w) * h, color.full);
+        return;
+    }
+    for (; h > 0; h--, dest += dest_width)
+        fillRun(dest, w, color.full);
+}
+
+/// RGB565 spread to 00000gggggg00000rrrrr000000bbbbb, leaving room above
+/// each channel for a 5-bit multiply
+static inline uint32_t spread565(uint16_t c)
+{
+    return (c | static_cast<uint32_t>(c) << 16) & 0x07E0F81F;
+}
+
+extern "C"
+void lvgl_gpudriver_blend(lv_disp_drv_t *, lv_color_t * dest, const lv_color_t * src,
+        uint32_t length, lv_opa_t opa)
+{
+    if (opa >= LV_OPA_MAX) {
+        memcpy(dest, src, length * sizeof(lv_color_t));
+        return;
+    }
+    if (opa <= LV_OPA_MIN)
+        return;
+
+    uint32_t alpha = (opa + 4) >> 3;
+    for (uint32_t i = 0; i < length; i++) {
+        uint32_t bg = spread565(dest[i].full);
+        uint32_t fg = spread565(src[i].full);
+        uint32_t mix = ((((fg - bg) * alpha) >> 5) + bg) & 0x07E0F81F;
+        dest[i].full = static_cast<uint16_t>(mix | mix >> 16);
+    }
+}
@@ -0,0 +1,47 @@
+/**
+ * These functions provide the LVGL GPU interface, filling the draw buffer
+ * with DMA.
+ *
+ * The F103 DMA can only move data, so fills use a memory to memory transfer
+ * from a fixed source address holding the colour. Blending needs arithmetic
+ * per pixel and is done by the CPU, two colour channels per multiply.
+ */
+#ifndef LVGL_GPU_DRIVER_H_
+#define LVGL_GPU_DRIVER_H_
+
+#include <cstdint>
+#include "lvgl/lvgl.h"
+
+/**
+ * Setup the DMA channel used for fills (DMA1 channel 2, channel 1 is the
+ * display flush).
+ */
+void initLvglGpuDriver();
+
+/**
+ * LVGL display driver fill callback. Waits for the transfer to complete.
+ *
+ * @param disp_drv
+ * @param dest_buf draw buffer
+ * @param dest_width draw buffer width in pixels
+ * @param fill_area relative to @p dest_buf
+ * @param color
+ */
+extern "C"
+void lvgl_gpudriver_fill(lv_disp_drv_t * disp_drv, lv_color_t * dest_buf, lv_coord_t dest_width,
+        const lv_area_t * fill_area, lv_color_t color);
+
+/**
+ * LVGL display driver blend callback.
+ *
+ * @param disp_drv
+ * @param dest
+ * @param src
+ * @param length pixels
+ * @param opa opacity of @p src
+ */
+extern "C"
+void lvgl_gpudriver_blend(lv_disp_drv_t * disp_drv, lv_color_t * dest, const lv_color_t * src,
+        uint32_t length, lv_opa_t opa);
+
+#endif /* LVGL_GPU_DRIVER_H_ */
@@ -79,6 +79,8 @@ int main()
 
     enableSpeaker(!settings.mute);
 
+    setOvenSsrMainsFreq(settings.mains_freq);
+
     // Calibrate touch if we have no stored setting
 
     if (!settings.touch_calib_mtx.valid())
@@ -0,0 +1,209 @@
+#include <oven/job_queue.h>
+
+bool JobQueue::addReflow(uint8_t profile_idx, OvenOperation::ReflowControl control, uint8_t count)
+{
+    if (state_ != State::idle || count == 0)
+        return false;
+
+    Job* last = num_jobs_ > 0 ? &jobs_[num_jobs_ - 1] : nullptr;
+    if (last != nullptr && last->type == Job::Type::reflow
+            && last->profile_idx == profile_idx && last->control == control) {
+        last->count = last->count + count > UINT8_MAX ? UINT8_MAX : last->count + count;
+    }
+    else {
+        if (num_jobs_ == max_jobs)
+            return false;
+        jobs_[num_jobs_++] = { Job::Type::reflow, count, profile_idx, control, 0, 0, { } };
+    }
+    change_count_++;
+    return true;
+}
+
+
+bool JobQueue::addBake(uint16_t time_s, uint16_t temp, uint8_t count)
+{
+    if (state_ != State::idle || count == 0)
+        return false;
+
+    Job* last = num_jobs_ > 0 ? &jobs_[num_jobs_ - 1] : nullptr;
+    if (last != nullptr && last->type == Job::Type::bake
+            && last->bake_time_s == time_s && last->bake_temp == temp) {
+        last->count = last->count + count > UINT8_MAX ? UINT8_MAX : last->count + count;
+    }
+    else {
+        if (num_jobs_ == max_jobs)
+            return false;
+        jobs_[num_jobs_++] = { Job::Type::bake, count, 0, OvenOperation::ReflowControl::pid, time_s, temp, { } };
+    }
+    change_count_++;
+    return true;
+}
+
+
+bool JobQueue::removeProfile(uint8_t profile_idx)
+{
+    if (state_ != State::idle)
+        return false;
+
+    uint8_t kept = 0;
+    for (uint8_t i = 0; i < num_jobs_; i++) {
+        Job& job = jobs_[i];
+        if (job.type == Job::Type::reflow) {
+            if (job.profile_idx == profile_idx)
+                continue;
+            if (job.profile_idx > profile_idx)
+                job.profile_idx--;
+        }
+        jobs_[kept++] = job;
+    }
+    num_jobs_ = kept;
+    change_count_++;
+    return true;
+}
+
+
+void JobQueue::clear()
+{
+    if (state_ != State::idle)
+        return;
+    num_jobs_ = 0;
+    change_count_++;
+}
+
+
+bool JobQueue::start()
+{
+    if (state_ != State::idle || num_jobs_ == 0)
+        return false;
+
+    for (uint8_t i = 0; i < num_jobs_; i++)
+        jobs_[i].stats = { };
+    current_job_ = 0;
+    loaded_ = true;
+    cooled_ = false;
+    phase_start_ms_ = get_millis_func_();
+    change_count_++;
+
+    // Oven may still be hot from a previous operation
+    if (!startRun())
+        state_ = State::next_run;
+    return true;
+}
+
+
+void JobQueue::stop()
+{
+    if (state_ == State::idle)
+        return;
+    if (state_ == State::running)
+        oven_operation_.stop();
+    state_ = State::idle;
+    change_count_++;
+}
+
+
+void JobQueue::process()
+{
+    switch (state_) {
+    case State::idle:
+        break;
+    case State::running:
+        if (run_complete_) {
+            finishRun();
+        }
+        else {
+            OvenOperation::State op_state = oven_operation_.getSnapshot().state;
+            if ((op_state == OvenOperation::State::stopped || op_state == OvenOperation::State::cooldown)
+                    && !oven_operation_.isEventPending()) {
+                // Stopped early or error, leave the rest for the operator
+                state_ = State::idle;
+                change_count_++;
+            }
+        }
+        break;
+    case State::next_run:
+    {
+        uint64_t now = get_millis_func_();
+        Job& job = jobs_[current_job_];
+        OvenOperation::Snapshot snapshot = oven_operation_.getSnapshot();
+        if (snapshot.state == OvenOperation::State::stopped && snapshot.temp >= ReflowProfiles::start_temp) {
+            // Warmed up again after the door closed, a reflow would refuse
+            // to start. Cool again, time since cooling counts as load wait.
+            if (cooled_) {
+                job.stats.load_wait_s += (now - phase_start_ms_) / 1000;
+                phase_start_ms_ = now;
+                cooled_ = false;
+            }
+            oven_operation_.stop();
+            change_count_++;
+            break;
+        }
+        if (!cooled_ && snapshot.state == OvenOperation::State::stopped) {
+            job.stats.cooldown_s += (now - phase_start_ms_) / 1000;
+            phase_start_ms_ = now;
+            cooled_ = true;
+            change_count_++;
+        }
+        if (!cooled_ || !loaded_)
+            break;
+
+        job.stats.load_wait_s += (now - phase_start_ms_) / 1000;
+        if (job.stats.runs_done >= job.count)
+            current_job_++;
+        if (!startRun()) {
+            state_ = State::idle;
+            change_count_++;
+        }
+        break;
+    }
+    }
+}
+
+
+bool JobQueue::startRun()
+{
+    const Job& job = jobs_[current_job_];
+    run_complete_ = false;
+
+    bool started;
+    if (job.type == Job::Type::reflow) {
+        if (job.profile_idx >= profiles_.getNumProfiles())
+            return false;
+        started = oven_operation_.startReflow(profiles_.getProfile(job.profile_idx),
+                [] { run_complete_ = true; }, job.control);
+    }
+    else {
+        started = oven_operation_.startBake(job.bake_time_s, job.bake_temp, [] { run_complete_ = true; });
+    }
+
+    if (started) {
+        state_ = State::running;
+        phase_start_ms_ = get_millis_func_();
+        loaded_ = false;
+        change_count_++;
+    }
+    return started;
+}
+
+
+void JobQueue::finishRun()
+{
+    uint64_t now = get_millis_func_();
+    Job& job = jobs_[current_job_];
+    job.stats.run_s += (now - phase_start_ms_) / 1000;
+    job.stats.runs_done++;
+    run_complete_ = false;
+
+    if (job.stats.runs_done >= job.count && current_job_ + 1 == num_jobs_) {
+        state_ = State::idle;
+    }
+    else {
+        state_ = State::next_run;
+        cooled_ = false;
+        phase_start_ms_ = now;
+    }
+    change_count_++;
+
+    if (run_complete_cb_ != nullptr)
+        run_complete_cb_();
+}
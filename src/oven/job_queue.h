@@ -0,0 +1,154 @@
+#ifndef SRC_OVEN_JOB_QUEUE_H_
+#define SRC_OVEN_JOB_QUEUE_H_
+
+#include <cstdint>
+#include "oven/oven_operation.h"
+#include "reflow/reflow_profiles.h"
+
+/**
+ * Runs a list of reflow/bake jobs back to back on top of @p OvenOperation.
+ *
+ * Each job is run @p Job::count times. After each run the oven is left in
+ * its forced cooldown, and the next run starts once the oven is below the
+ * reflow start temperature and the operator has acknowledged loading the
+ * next board (which may be done while the oven cools). Time spent running,
+ * cooling and waiting for the operator is accumulated per job.
+ *
+ * All functions are called from the UI loop.
+ */
+class JobQueue {
+public:
+    using GetMillisFunc = uint64_t (*)();
+    using RunCompleteCb = void (*)();
+
+    inline static constexpr uint8_t max_jobs = 4;
+
+    enum class State : uint8_t {
+        idle,       /**< Not running, jobs may be edited */
+        running,    /**< Oven operation in progress */
+        next_run    /**< Waiting for cooldown and operator before next run */
+    };
+
+    /// Totals over the completed runs of a job
+    struct Stats {
+        uint8_t runs_done;
+        /// Oven operation, start to completion
+        uint32_t run_s;
+        /// Completion until the oven is cool enough for the next run
+        uint32_t cooldown_s;
+        /// Oven cool until the operator acknowledged the next board
+        uint32_t load_wait_s;
+    };
+
+    struct Job {
+        enum class Type : uint8_t { reflow, bake };
+        Type type;
+        uint8_t count;
+        /// Reflow profile index
+        uint8_t profile_idx;
+        /// Reflow profile tracking method
+        OvenOperation::ReflowControl control;
+        /// Bake duration
+        uint16_t bake_time_s;
+        /// Bake temperature in 0.1°C
+        uint16_t bake_temp;
+        Stats stats;
+    };
+
+    JobQueue(OvenOperation& oven_operation, ReflowProfiles& profiles, GetMillisFunc get_millis_func)
+            : oven_operation_(oven_operation), profiles_(profiles), get_millis_func_(get_millis_func)
+    { }
+
+    /**
+     * Append a reflow job, or add to the count of the last job if it is the
+     * same profile and control.
+     *
+     * @param profile_idx
+     * @param control profile tracking method
+     * @param count
+     *
+     * @return false if running or the queue is full
+     */
+    bool addReflow(uint8_t profile_idx, OvenOperation::ReflowControl control, uint8_t count);
+
+    /**
+     * Append a bake job, or add to the count of the last job if it is the
+     * same bake.
+     *
+     * @param time_s bake duration
+     * @param temp bake temperature in 0.1°C
+     * @param count
+     *
+     * @return false if running or the queue is full
+     */
+    bool addBake(uint16_t time_s, uint16_t temp, uint8_t count);
+
+    /**
+     * Remove the reflow jobs for profile @p profile_idx and renumber those
+     * for the later profiles. Call before deleting the profile.
+     *
+     * @return false if not idle, the profile must not be deleted
+     */
+    bool removeProfile(uint8_t profile_idx);
+
+    /// Remove all jobs. Noop unless idle.
+    void clear();
+
+    /**
+     * Start the first job, assuming the first board is loaded. Statistics
+     * from any previous run of the queue are reset.
+     *
+     * @return false if already running or there are no jobs
+     */
+    bool start();
+
+    /// Stop the oven operation and the queue
+    void stop();
+
+    /// Operator has loaded the next board
+    void acknowledgeLoaded() { loaded_ = true; }
+
+    /**
+     * Advance the queue. Call regularly from the UI loop after
+     * @p OvenOperation::dispatchEvents.
+     */
+    void process();
+
+    /// Set a function to call after each completed run. May be null.
+    void setRunCompleteCb(RunCompleteCb cb) { run_complete_cb_ = cb; }
+
+    State getState() const { return state_; }
+    uint8_t getNumJobs() const { return num_jobs_; }
+    /// Job being run or waited for, valid while not idle
+    uint8_t getCurrentJob() const { return current_job_; }
+    /// True once the operator has acknowledged the next board
+    bool isLoaded() const { return loaded_; }
+    const Job& getJob(uint8_t idx) const { return jobs_[idx < max_jobs ? idx : 0]; }
+
+    /// Incremented on every change to the queue or its state, to detect
+    /// when a display needs updating
+    uint16_t getChangeCount() const { return change_count_; }
+
+private:
+    OvenOperation& oven_operation_;
+    ReflowProfiles& profiles_;
+    const GetMillisFunc get_millis_func_;
+    RunCompleteCb run_complete_cb_ = nullptr;
+
+    Job jobs_[max_jobs];
+    uint8_t num_jobs_ = 0;
+    uint8_t current_job_ = 0;
+    State state_ = State::idle;
+    bool loaded_ = false;
+    bool cooled_ = false;
+    uint64_t phase_start_ms_ = 0;
+    uint16_t change_count_ = 0;
+
+    /// Set by the operation complete callback
+    inline static volatile bool run_complete_ = false;
+
+    bool startRun();
+    void finishRun();
+};
+
+#endif /* SRC_OVEN_JOB_QUEUE_H_ */
@@ -0,0 +1,384 @@
+#ifndef SRC_OVEN_OVEN_CHARACTERIZER_H_
+#define SRC_OVEN_OVEN_CHARACTERIZER_H_
+
+#include <cstdint>
+#include <algorithm>
+#include "fixed_point.h"
+#include "oven/oven_model.h"
+
+/**
+ * Running least squares fit of y = m*x + b. Only the sums are stored so any
+ * number of samples may be added.
+ */
+class LinearFit {
+public:
+    void reset() { *this = LinearFit(); }
+
+    void add(int32_t x, Q16 y)
+    {
+        n_++;
+        sx_ += x;
+        sxx_ += static_cast<int64_t>(x) * x;
+        sy_ += y.raw();
+        sxy_ += static_cast<int64_t>(x) * y.raw();
+    }
+
+    /// Adjust the sums as if y - (m*x + b) had been added instead of y
+    void subtract(Q16 m, Q16 b)
+    {
+        sy_ -= m.raw() * sx_ + b.raw() * n_;
+        sxy_ -= m.raw() * sxx_ + b.raw() * sx_;
+    }
+
+    uint16_t count() const { return n_; }
+
+    /// Fit the slope only, with the line passing through (0, @p b)
+    bool solveSlope(Q16 b, Q16* m) const
+    {
+        if (sxx_ == 0)
+            return false;
+        *m = Q16::fromRaw((sxy_ - b.raw() * sx_) / sxx_);
+        return true;
+    }
+
+    /// @return false if there are too few samples or no spread in x
+    bool solve(Q16* m, Q16* b) const
+    {
+        if (n_ < 2)
+            return false;
+        int64_t den = static_cast<int64_t>(n_) * sxx_ - sx_ * sx_;
+        if (den == 0)
+            return false;
+        int64_t m_raw = (static_cast<int64_t>(n_) * sxy_ - sx_ * sy_) / den;
+        *m = Q16::fromRaw(m_raw);
+        *b = Q16::fromRaw((sy_ - m_raw * sx_) / n_);
+        return true;
+    }
+
+private:
+    uint16_t n_ = 0;
+    int64_t sx_ = 0;
+    int64_t sxx_ = 0;
+    /// y sums are in Q16 raw units
+    int64_t sy_ = 0;
+    int64_t sxy_ = 0;
+};
+
+
+/**
+ * Guided characterization run that measures the @p OvenModel constants of the
+ * attached oven. Must be started near ambient temperature.
+ *
+ * The run steps through the following phases:
+ *
+ * 1. heating: 100% power to @p heat_top_temp. The rise at power on gives the
+ *    element lag at ambient, later samples the 100% heating curve.
+ * 2. cooling: 0% power, door closed, to @p partial_start_temp. The overshoot
+ *    after power off gives the element lag at temperature, later samples the
+ *    closed door cooling curve.
+ * 3. partial_heating: @p partial_power to @p partial_top_temp for the power
+ *    adjustment factor.
+ * 4. door_cooling: 0% power, door open, to @p door_end_temp for the open door
+ *    cooling curve. Only the upper part of the curve is covered so the
+ *    intercept is shared with the closed door fit.
+ *
+ * Heating samples include the cooling losses, so the fits are solved in
+ * the order cooling, heating, power, door. Rates are measured over
+ * @p slope_period_s to reduce thermocouple quantization noise.
+ */
+class OvenCharacterizer {
+public:
+    using GetMillisFunc = uint64_t (*)();
+
+    enum class Phase : uint8_t {
+        heating, cooling, partial_heating, door_cooling, finished
+    };
+
+    // 0.1°C units
+    inline static constexpr uint16_t max_start_temp = 500;
+    inline static constexpr uint16_t heat_top_temp = 2300;
+    inline static constexpr uint16_t partial_start_temp = 1200;
+    inline static constexpr uint16_t partial_top_temp = 2000;
+    inline static constexpr uint16_t door_end_temp = 1000;
+    inline static constexpr uint8_t partial_power = 50;
+
+    OvenCharacterizer(GetMillisFunc get_millis_func) : get_millis_func_(get_millis_func) { }
+
+    /**
+     * Reset state and begin the heating phase.
+     *
+     * @param temp current (ambient) temperature in 0.1°C
+     */
+    void init(uint16_t temp)
+    {
+        phase_ = Phase::heating;
+        ambient_temp_ = temp;
+        phase_start_ms_ = get_millis_func_();
+        last_time_ms_ = phase_start_ms_;
+        temp_hist_[0] = temp_hist_[1] = temp;
+        samples_ = 0;
+        peak_temp_ = 0;
+        peak_time_s_ = 0;
+        rise_len_ = 0;
+        rise_max_ = 0;
+        rise_max_time_s_ = 0;
+        heat_fit_.reset();
+        cool_fit_.reset();
+        door_fit_.reset();
+        pwr_sum_ = 0;
+        pwr_n_ = 0;
+        model_ = default_oven_model;
+        valid_ = false;
+    }
+
+    /**
+     * Record a sample and advance the run if at least one second has elapsed
+     * since the previous sample.
+     *
+     * @param temp current temperature in 0.1°C
+     * @param power_level receives the power level to apply
+     * @param door_opening receives the door opening to apply
+     *
+     * @return true if @p power_level and @p door_opening were updated
+     */
+    bool compute(uint16_t temp, uint8_t* power_level, uint8_t* door_opening)
+    {
+        uint64_t now = get_millis_func_();
+        if (now - last_time_ms_ < sample_period_ms)
+            return false;
+        last_time_ms_ = now;
+
+        uint16_t phase_time_s = (now - phase_start_ms_) / 1000;
+        int32_t temp_diff = static_cast<int32_t>(temp) - ambient_temp_;
+        // Rate over the last slope_period_s samples
+        Q16 dtds = Q16::fromRatio(static_cast<int32_t>(temp) - temp_hist_[1], slope_period_s);
+        temp_hist_[1] = temp_hist_[0];
+        temp_hist_[0] = temp;
+        bool have_slope = ++samples_ > slope_period_s;
+
+        switch (phase_) {
+        case Phase::heating:
+            if (have_slope && rise_len_ < max_rise_len && (phase_time_s % slope_period_s) == 0) {
+                if (rise_len_ == 0)
+                    rise_start_s_ = phase_time_s;
+                uint8_t rate = std::clamp<int32_t>(dtds.round(), 0, UINT8_MAX);
+                rise_dtds_[rise_len_++] = rate;
+                if (rate > rise_max_) {
+                    rise_max_ = rate;
+                    rise_max_time_s_ = phase_time_s;
+                }
+            }
+            if (have_slope && isRisePlateau(phase_time_s))
+                heat_fit_.add(temp_diff, dtds);
+            if (temp >= heat_top_temp)
+                startPhase(Phase::cooling, now);
+            break;
+
+        case Phase::cooling:
+            trackPeak(temp, phase_time_s);
+            if (have_slope && isPastPeak(phase_time_s))
+                cool_fit_.add(temp_diff, dtds);
+            if (temp <= partial_start_temp) {
+                if (!solveHeatingFits()) {
+                    phase_ = Phase::finished;
+                    break;
+                }
+                startPhase(Phase::partial_heating, now);
+            }
+            break;
+
+        case Phase::partial_heating:
+            if (have_slope && phase_time_s >= model_.lagSeconds(partial_start_temp) + slope_period_s) {
+                // Ratio of measured heating to the 100% curve, power factor excluded
+                Q16 heat_dtds = (model_.heat_m * temp_diff + model_.heat_b) * partial_power / 100;
+                Q16 cool_dtds = model_.cool_m * temp_diff + model_.cool_b;
+                if (heat_dtds > 0) {
+                    pwr_sum_ += (dtds - cool_dtds) / heat_dtds;
+                    pwr_n_++;
+                }
+            }
+            if (temp >= partial_top_temp)
+                startPhase(Phase::door_cooling, now);
+            break;
+
+        case Phase::door_cooling:
+            trackPeak(temp, phase_time_s);
+            if (have_slope && isPastPeak(phase_time_s))
+                door_fit_.add(temp_diff, dtds);
+            if (temp <= door_end_temp) {
+                valid_ = solveRemainingFits();
+                phase_ = Phase::finished;
+            }
+            break;
+
+        case Phase::finished:
+            break;
+        }
+
+        *power_level = phase_ == Phase::heating ? 100
+                : phase_ == Phase::partial_heating ? partial_power : 0;
+        *door_opening = phase_ == Phase::door_cooling ? 100 : 0;
+        return true;
+    }
+
+    Phase getPhase() const { return phase_; }
+
+    bool isFinished() const { return phase_ == Phase::finished; }
+
+    /**
+     * @param model receives the fitted model
+     *
+     * @return false if not finished or the fit failed
+     */
+    bool getResult(OvenModel* model) const
+    {
+        if (!isFinished() || !valid_)
+            return false;
+        *model = model_;
+        return true;
+    }
+
+private:
+    static constexpr uint16_t sample_period_ms = 1000;
+    static constexpr uint8_t slope_period_s = 2;
+    /// Rise rates are logged every slope_period_s while heating from
+    /// ambient, which limits the measurable lag to max_lag_s
+    static constexpr uint16_t max_lag_s = 180;
+    static constexpr uint8_t max_rise_len = max_lag_s / slope_period_s;
+    static constexpr uint16_t min_fit_samples = 20;
+
+    const GetMillisFunc get_millis_func_;
+
+    Phase phase_ = Phase::finished;
+    uint16_t ambient_temp_ = 0;
+    uint64_t phase_start_ms_ = 0;
+    uint64_t last_time_ms_ = 0;
+    uint16_t temp_hist_[slope_period_s] = { };
+    uint16_t samples_ = 0;
+    uint16_t peak_temp_ = 0;
+    uint16_t peak_time_s_ = 0;
+    uint8_t rise_dtds_[max_rise_len] = { };
+    uint8_t rise_len_ = 0;
+    uint16_t rise_start_s_ = 0;
+    uint8_t rise_max_ = 0;
+    uint16_t rise_max_time_s_ = 0;
+    LinearFit heat_fit_;
+    LinearFit cool_fit_;
+    LinearFit door_fit_;
+    Q16 pwr_sum_;
+    uint16_t pwr_n_ = 0;
+    OvenModel model_ = default_oven_model;
+    bool valid_ = false;
+
+    void startPhase(Phase phase, uint64_t now)
+    {
+        phase_ = phase;
+        phase_start_ms_ = now;
+        peak_temp_ = 0;
+        peak_time_s_ = 0;
+    }
+
+    /// Temperature keeps rising after power off until the lagged power decays
+    void trackPeak(uint16_t temp, uint16_t phase_time_s)
+    {
+        if (temp > peak_temp_) {
+            peak_temp_ = temp;
+            peak_time_s_ = phase_time_s;
+        }
+    }
+
+    /// Lagged power has fully decayed (peak occurs before the lag period)
+    bool isPastPeak(uint16_t phase_time_s) const
+    {
+        return phase_time_s > peak_time_s_ * 2 + slope_period_s;
+    }
+
+    /**
+     * The rate stops rising once the lagged power reaches 100%. While still
+     * ramping the lag estimate tracks the elapsed time and the maximum keeps
+     * increasing, so require both to have settled.
+     */
+    bool isRisePlateau(uint16_t phase_time_s) const
+    {
+        static constexpr uint16_t min_settled_s = 10;
+        uint16_t lag_s = riseLag(Q16(rise_max_) / 2);
+        return lag_s > 0
+                && phase_time_s >= lag_s * 5 / 4 + slope_period_s
+                && phase_time_s - rise_max_time_s_ >= std::max<uint16_t>(min_settled_s, lag_s / 4);
+    }
+
+    /**
+     * Moving average lag ramps the rate linearly up to the full rate over the
+     * lag period, so the rate reaches half of the full rate at lag/2.
+     *
+     * @param half_rate
+     *
+     * @return lag in seconds, 0 if @p half_rate was not reached
+     */
+    uint16_t riseLag(Q16 half_rate) const
+    {
+        uint8_t i = 0;
+        while (i < rise_len_ && rise_dtds_[i] < half_rate)
+            i++;
+        if (i == rise_len_)
+            return 0;
+        // Each rate is measured over the slope_period_s before its timestamp
+        return (rise_start_s_ + i * slope_period_s) * 2 - slope_period_s;
+    }
+
+    /// Solve the cooling/heating curves and lag. Called at the end of the
+    /// cooling phase.
+    bool solveHeatingFits()
+    {
+        if (cool_fit_.count() < min_fit_samples || heat_fit_.count() < min_fit_samples)
+            return false;
+        if (!cool_fit_.solve(&model_.cool_m, &model_.cool_b))
+            return false;
+        // Heating samples include cooling losses
+        heat_fit_.subtract(model_.cool_m, model_.cool_b);
+        if (!heat_fit_.solve(&model_.heat_m, &model_.heat_b))
+            return false;
+        model_.max_heat_rate = model_.heat_b;
+
+        uint16_t ambient_lag_s = riseLag((model_.heat_b + model_.cool_b) / 2);
+        if (ambient_lag_s == 0)
+            return false;
+
+        // After power off the heating rate decays linearly to 0 over the lag
+        // period and the peak is where it equals the cooling rate:
+        // t_peak = lag * (1 - cool / heat)
+        int32_t top_diff = static_cast<int32_t>(peak_temp_) - ambient_temp_;
+        Q16 top_heat = model_.heat_m * top_diff + model_.heat_b;
+        Q16 top_cool = -(model_.cool_m * top_diff + model_.cool_b);
+        if (top_heat <= top_cool)
+            return false;
+        uint16_t top_lag_s = (Q16(peak_time_s_) * top_heat / (top_heat - top_cool)).round();
+
+        model_.lag_min_s = std::max<uint16_t>(1, std::min(top_lag_s, ambient_lag_s));
+        model_.lag_ref_temp = ambient_temp_ + ambient_lag_s * model_.lag_div;
+
+        // Reject fits that don't describe a heating element in a box
+        return model_.cool_m < 0 && model_.heat_b > 0;
+    }
+
+    /// Solve the power adjustment and door open cooling. Called at the end
+    /// of the run.
+    bool solveRemainingFits()
+    {
+        if (door_fit_.count() < min_fit_samples || pwr_n_ < min_fit_samples)
+            return false;
+
+        // pwr_adj(100) = 1 so pwr_m = (1 - pwr_adj(p)) / (100 - p)
+        Q16 pwr_adj = pwr_sum_ / pwr_n_;
+        model_.pwr_m = (Q16(1) - pwr_adj) / (100 - partial_power);
+        model_.pwr_b = Q16(1) - model_.pwr_m * 100;
+
+        model_.door_cool_b = model_.cool_b;
+        if (!door_fit_.solveSlope(model_.door_cool_b, &model_.door_cool_m))
+            return false;
+
+        return model_.door_cool_m < 0 && model_.pwr_b > 0;
+    }
+};
+
+#endif /* SRC_OVEN_OVEN_CHARACTERIZER_H_ */
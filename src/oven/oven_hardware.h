@@ -4,10 +4,16 @@
 #include <cstdint>
 #include "devices/oven_ssr.h"
 #include "devices/thermocouple.h"
+#include "devices/door_servo.h"
+#include "fixed_point.h"
 
+// Set to 1 to replace the SSR/thermocouple with the thermal model in oven_sim.h
+#ifndef MOCK_OVEN
 #define MOCK_OVEN 0
+#endif
 #if MOCK_OVEN
 #include "oven_sim.h"
+#include "oven/temp_estimator.h"
 #endif
 
 /**
@@ -16,7 +22,11 @@
 class OvenHardware {
 public:
 
+#if MOCK_OVEN
+    OvenHardware(OvenSim& oven_sim) : sim_(oven_sim) { };
+#else
     OvenHardware() { };
+#endif
 
     ~OvenHardware() { }
 
@@ -30,50 +40,168 @@ public:
     void setPowerLevel(uint8_t percentage)
     {
     #if MOCK_OVEN
-        power_lvl_ = percentage;
-        power_on_ = percentage > 0;
+        sim_.setPowerLevel(percentage);
     #else
         setOvenSsr(percentage);
     #endif
     }
 
     /**
-     * Open/close the oven door.
+     * Open/close the oven door. The door moves to the new opening at a
+     * limited rate via @p updateDoor.
      *
      * @param opening amount 0->100 where 0=closed and 100=open.
      */
     void setDoorOpening(uint8_t opening)
     {
-        door_opening_ = opening;
+        door_target_ = opening > 100 ? 100 : opening;
+    }
+
+    /**
+     * Move the door servo towards the requested opening by at most
+     * @p door_slew_per_update. Call at the control tick rate.
+     */
+    void updateDoor()
+    {
+        if (door_opening_ == door_target_)
+            return;
+        if (door_opening_ < door_target_)
+            door_opening_ = door_target_ - door_opening_ > door_slew_per_update
+                    ? door_opening_ + door_slew_per_update : door_target_;
+        else
+            door_opening_ = door_opening_ - door_target_ > door_slew_per_update
+                    ? door_opening_ - door_slew_per_update : door_target_;
+    #if MOCK_OVEN
+        sim_.setDoorOpening(door_opening_);
+    #else
+        setDoorServo(door_servo_closed_deg + door_opening_ * (door_servo_open_deg - door_servo_closed_deg) / 100);
+    #endif
     }
 
     /**
-     * Read the current oven temperature.
+     * Read the current oven temperature, as estimated from the thermocouple
+     * conversions up to the latest one. Does not access the bus.
      *
      * @return temperature in tenths of a degrees Celcius (e.g. 1234 = 123.4°C)
      */
     uint16_t getTemp()
     {
     #if MOCK_OVEN
-        return getMockTemp(power_lvl_);
+        updateSimEstimate();
+        return estimator_.getTemp().round();
+    #else
+        return getTempSample().est_temp.round();
+    #endif
+    }
+
+    /**
+     * Set the number of thermocouple conversions averaged per temperature
+     * reading, trading noise against latency.
+     *
+     * @param samples 1, 2, 4, 8 or 16
+     */
+    void setTempAveraging(uint8_t samples)
+    {
+    #if MOCK_OVEN
+        (void)samples;
+    #else
+        setThermocoupleAveraging(samples);
+    #endif
+    }
+
+    /**
+     * Read the estimated rate of change of the oven temperature.
+     *
+     * @return 0.1°C/s
+     */
+    Q16 getTempRate()
+    {
+    #if MOCK_OVEN
+        updateSimEstimate();
+        return estimator_.getRate();
     #else
-        return readTemp();
+        return getTempSample().est_rate;
+    #endif
+    }
+
+    /**
+     * Return the time at which the temperature returned by @p getTemp was
+     * measured.
+     *
+     * @return @p Libp::getMillis() timestamp
+     */
+    uint32_t getTempTimestamp()
+    {
+    #if MOCK_OVEN
+        return sim_.getMillis();
+    #else
+        return getTempSample().timestamp_ms;
+    #endif
+    }
+
+    /**
+     * Return the latched thermocouple fault. While set the SSR is held off
+     * regardless of @p setPowerLevel.
+     *
+     * @return @p TcFault bits, 0 = no fault
+     */
+    uint8_t getSensorFault()
+    {
+    #if MOCK_OVEN
+        return 0;
+    #else
+        return getThermocoupleFault();
+    #endif
+    }
+
+    /**
+     * Clear the latched thermocouple fault and allow the SSR to be turned on
+     * again.
+     *
+     * @return false if the fault is still present
+     */
+    bool clearSensorFault()
+    {
+    #if MOCK_OVEN
+        return true;
+    #else
+        return clearThermocoupleFault();
     #endif
     }
 
 #if MOCK_OVEN
-    uint8_t power_lvl_ = 0;
-    bool power_on_ = false;
-    bool getPowerOn()       { return power_on_;  }
-    uint8_t getPowerLevel() { return power_lvl_; }
+    bool getPowerOn()       { return sim_.getPowerLevel() > 0; }
+    uint8_t getPowerLevel() { return sim_.getPowerLevel();     }
 #else
     bool getPowerOn()       { return getOvenSsr() > 0; }
     uint8_t getPowerLevel() { return getOvenSsr();     }
 #endif
-    bool getDoorOpening()   { return door_opening_;    }
+    uint8_t getDoorOpening() { return door_opening_;   }
 
 private:
-    uint8_t door_opening_;
+    /// Opening percentage per @p updateDoor call, full travel in 2s at 100ms
+    inline static constexpr uint8_t door_slew_per_update = 5;
+
+#if MOCK_OVEN
+    OvenSim& sim_;
+    /// Runs the estimator on each simulated sample like the thermocouple
+    /// driver does on target
+    TempEstimator estimator_;
+    uint64_t last_sample_ms_ = 0;
+    bool have_sample_ = false;
+
+    void updateSimEstimate()
+    {
+        uint16_t temp = sim_.getTemp();
+        if (have_sample_ && sim_.getSampleTime() == last_sample_ms_)
+            return;
+        last_sample_ms_ = sim_.getSampleTime();
+        have_sample_ = true;
+        estimator_.addSample(temp, last_sample_ms_);
+    }
+#endif
+    uint8_t door_opening_ = 0;
+    uint8_t door_target_ = 0;
 };
 
 #endif /* HARDWARE_OVEN_HARDWARE_H_ */
@@ -0,0 +1,138 @@
+#ifndef SRC_OVEN_OVEN_MODEL_H_
+#define SRC_OVEN_OVEN_MODEL_H_
+
+#include <cstdint>
+#include <algorithm>
+#include "fixed_point.h"
+
+/**
+ * Thermal model of an oven.
+ *
+ * Rates are in 0.1°C per second as a function of the difference between the
+ * oven and ambient temperature (0.1°C):
+ *
+ *     cooling: dT/ds = cool_m * temp_diff + cool_b
+ *     heating: dT/ds = (heat_m * temp_diff + heat_b) * pwr/100 * pwr_adj
+ *     pwr_adj = pwr_m * pwr + pwr_b
+ *
+ * Door open cooling replaces the closed door cooling term in proportion to
+ * the door opening. The heating elements respond to power changes with a lag
+ * modelled as a moving average of the power over
+ * max(lag_min_s, (lag_ref_temp - temp) / lag_div) seconds.
+ *
+ * Trivially copyable so it can be stored in the settings EEPROM.
+ */
+struct OvenModel {
+    Q16 cool_m;
+    Q16 cool_b;
+    Q16 door_cool_m;
+    Q16 door_cool_b;
+    Q16 heat_m;
+    Q16 heat_b;
+    Q16 max_heat_rate;
+    Q16 pwr_m;
+    Q16 pwr_b;
+    uint16_t lag_min_s;
+    /// 0.1°C
+    uint16_t lag_ref_temp;
+    uint16_t lag_div;
+
+    /**
+     * @param temp_diff oven temperature above ambient (0.1°C)
+     * @param power lagged power level percentage
+     * @param door_opening 0 = closed -> 100 = open
+     * @param millis time step
+     *
+     * @return temperature change over @p millis in 0.1°C
+     */
+    Q16 calcDtDs(Q16 temp_diff, Q16 power, uint8_t door_opening, uint16_t millis) const
+    {
+        Q16 cool_dtds = cool_m * temp_diff + cool_b;
+        if (door_opening > 0) {
+            Q16 door_dtds = door_cool_m * temp_diff + door_cool_b;
+            cool_dtds += (door_dtds - cool_dtds) * Q16::fromRatio(door_opening, 100);
+        }
+        Q16 heat_dtds = heat_m * temp_diff + heat_b;
+        Q16 pwr_adj = power / 100 * (power * pwr_m + pwr_b);
+        heat_dtds = heat_dtds * pwr_adj;
+        heat_dtds = std::min(heat_dtds, max_heat_rate);
+        return (cool_dtds + heat_dtds) * Q16::fromRatio(millis, 1000);
+    }
+
+    /**
+     * Inverse of @p calcDtDs with the door closed and the lagged power
+     * settled.
+     *
+     * @param temp_diff oven temperature above ambient (0.1°C)
+     * @param rate required rate of change in 0.1°C/s
+     *
+     * @return power level percentage, clamped to 0 -> 100
+     */
+    Q16 powerForRate(Q16 temp_diff, Q16 rate) const
+    {
+        Q16 heat_dtds = std::min(heat_m * temp_diff + heat_b, max_heat_rate);
+        Q16 needed = rate - (cool_m * temp_diff + cool_b);
+        if (needed <= 0 || heat_dtds <= 0)
+            return 0;
+        if (needed >= heat_dtds * (pwr_m * 100 + pwr_b))
+            return 100;
+
+        // Solve pwr_m*p^2 + pwr_b*p - 100*needed/heat = 0 for p
+        Q16 c = needed * 100 / heat_dtds;
+        if (pwr_m == 0)
+            return c / pwr_b;
+        Q16 disc = pwr_b * pwr_b + pwr_m * c * 4;
+        // Newton's method for sqrt(disc), converges from above
+        Q16 root = std::max(disc, Q16(1));
+        for (uint8_t i = 0; i < 8; i++)
+            root = (root + disc / root) / 2;
+        return ((root - pwr_b) / (pwr_m * 2)).clamp(0, 100);
+    }
+
+    /**
+     * Inverse of @p calcDtDs with the heating off.
+     *
+     * @param temp_diff oven temperature above ambient (0.1°C)
+     * @param rate required rate of change in 0.1°C/s
+     *
+     * @return door opening 0 -> 100
+     */
+    Q16 doorOpeningForRate(Q16 temp_diff, Q16 rate) const
+    {
+        Q16 cool_dtds = cool_m * temp_diff + cool_b;
+        Q16 door_dtds = door_cool_m * temp_diff + door_cool_b;
+        if (rate >= cool_dtds)
+            return 0;
+        if (rate <= door_dtds)
+            return 100;
+        return ((rate - cool_dtds) * 100 / (door_dtds - cool_dtds)).clamp(0, 100);
+    }
+
+    /**
+     * @param temp oven temperature (0.1°C)
+     *
+     * @return heating element lag in seconds
+     */
+    uint16_t lagSeconds(uint16_t temp) const
+    {
+        return std::max<int32_t>(lag_min_s, (static_cast<int32_t>(lag_ref_temp) - temp) / lag_div);
+    }
+};
+
+/// Model measured on the original build, used until a characterization run
+inline constexpr OvenModel default_oven_model = {
+    .cool_m        = Q16::fromFloat(-.002115),
+    .cool_b        = Q16::fromFloat( .6675),
+    .door_cool_m   = Q16::fromFloat(-.0055),
+    .door_cool_b   = Q16::fromFloat( .6675),
+    .heat_m        = Q16::fromFloat(-.0015),
+    .heat_b        = 25,
+    .max_heat_rate = 25,
+    .pwr_m         = Q16::fromFloat(.002),
+    .pwr_b         = Q16::fromFloat(.80),
+    .lag_min_s     = 15,
+    .lag_ref_temp  = 1700,
+    .lag_div       = 20,
+};
+
+#endif /* SRC_OVEN_OVEN_MODEL_H_ */
@@ -0,0 +1,179 @@
+#ifndef SRC_OVEN_OVEN_MONITOR_H_
+#define SRC_OVEN_OVEN_MONITOR_H_
+
+#include <cstdint>
+#include <algorithm>
+#include "fixed_point.h"
+#include "oven/oven_model.h"
+
+/**
+ * Compares the measured rate of change of the oven temperature against the
+ * rate the @p OvenModel predicts for the applied power and door opening, to
+ * detect hardware problems within seconds rather than when an operation
+ * overruns.
+ *
+ * The heating element lag is modelled as in @p OvenSim, a moving average of
+ * the power in one second steps. A condition must persist for @p persist_ms
+ * before it is reported, covering the estimator settling and short model
+ * errors.
+ *
+ * Detection is only as good as the model: a door opened at low temperatures
+ * barely changes the cooling rate and won't be noticed, and a probe detached
+ * while heating from cold looks the same as a failed heater.
+ */
+class OvenMonitor {
+public:
+    enum class Anomaly : uint8_t {
+        none,
+        door_open,          /**< Losing heat faster than the model allows */
+        probe_detached,     /**< Falling faster than with the door fully open */
+        no_heating,         /**< Heater failed (or probe outside the oven) */
+        ssr_stuck_on        /**< Heating with the power off */
+    };
+
+    /// Condition must hold this long before it is reported
+    inline static constexpr uint16_t persist_ms = 5000;
+    /// Rate margins in 0.1°C/s
+    inline static constexpr Q16 door_margin = 5;
+    inline static constexpr Q16 probe_margin = 10;
+    inline static constexpr Q16 ssr_margin = 5;
+    /// Heating must be expected to add at least this rate (0.1°C/s) to judge
+    /// the heater, and deliver at least 1/@p min_heating_div of it
+    inline static constexpr Q16 min_heating = 5;
+    inline static constexpr uint8_t min_heating_div = 4;
+    /// Lagged power below which the elements are considered off
+    inline static constexpr uint8_t off_power = 5;
+    /// Longest heating element lag tracked, seconds
+    inline static constexpr uint8_t max_lag_s = 120;
+
+    enum class Checks : uint8_t {
+        none,
+        ssr_only,   /**< No operation running, the door may be opened by hand */
+        all
+    };
+
+    /// Clear any reported anomaly, e.g. when a new operation starts
+    void clear()
+    {
+        anomaly_ = Anomaly::none;
+        pending_ = Anomaly::none;
+    }
+
+    /**
+     * Check the latest temperature estimate. Call regularly in every state
+     * to track the lagged power. Once an anomaly is reported it is held
+     * until @p clear.
+     *
+     * @param model
+     * @param temp_diff oven temperature above ambient (0.1°C)
+     * @param lag_s model heating element lag at the current temperature
+     * @param rate estimated rate of change (0.1°C/s)
+     * @param power power level percentage applied
+     * @param door_opening 0 = closed -> 100 = open
+     * @param checks conditions to look for
+     * @param now_ms
+     */
+    void update(const OvenModel& model, Q16 temp_diff, uint16_t lag_s, Q16 rate,
+            uint8_t power, uint8_t door_opening, Checks checks, uint32_t now_ms)
+    {
+        if (!valid_) {
+            valid_ = true;
+            step_start_ms_ = now_ms;
+            last_ms_ = now_ms;
+            last_power_ = power;
+            pending_since_ms_ = now_ms;
+            return;
+        }
+        addPower(power, lag_s, now_ms);
+
+        if (anomaly_ != Anomaly::none)
+            return;
+
+        Anomaly found = checks == Checks::none
+                ? Anomaly::none : check(model, temp_diff, rate, power, door_opening, checks);
+        if (found != pending_) {
+            pending_ = found;
+            pending_since_ms_ = now_ms;
+        }
+        else if (found != Anomaly::none && now_ms - pending_since_ms_ >= persist_ms) {
+            anomaly_ = found;
+        }
+    }
+
+    Anomaly getAnomaly() const { return anomaly_; }
+
+    static const char* getAnomalyText(Anomaly anomaly)
+    {
+        switch (anomaly) {
+        case Anomaly::door_open:      return "Oven door open";
+        case Anomaly::probe_detached: return "Thermocouple detached";
+        case Anomaly::no_heating:     return "Oven not heating";
+        case Anomaly::ssr_stuck_on:   return "Heating with power off, SSR failed?";
+        case Anomaly::none:
+        default:                      return "No anomaly";
+        }
+    }
+
+private:
+    /// Average power of each of the last @p max_lag_s steps, newest at
+    /// @p step_idx_
+    uint8_t step_power_[max_lag_s] = { };
+    uint8_t step_idx_ = 0;
+    /// Power level percentage * ms since @p step_start_ms_
+    uint32_t power_ms_ = 0;
+    uint32_t step_start_ms_ = 0;
+    uint8_t last_power_ = 0;
+    Q16 lagged_power_;
+    Anomaly anomaly_ = Anomaly::none;
+    /// Condition seen since @p pending_since_ms_
+    Anomaly pending_ = Anomaly::none;
+    uint32_t pending_since_ms_ = 0;
+    uint32_t last_ms_ = 0;
+    bool valid_ = false;
+
+    void addPower(uint8_t power, uint16_t lag_s, uint32_t now_ms)
+    {
+        // Power set at the previous update applied until now
+        power_ms_ += last_power_ * (now_ms - last_ms_);
+        last_power_ = power;
+        last_ms_ = now_ms;
+        if (now_ms - step_start_ms_ < 1000)
+            return;
+
+        step_idx_ = step_idx_ + 1 == max_lag_s ? 0 : step_idx_ + 1;
+        step_power_[step_idx_] = std::min<uint32_t>(power_ms_ / (now_ms - step_start_ms_), 100);
+        step_start_ms_ = now_ms;
+        power_ms_ = 0;
+
+        uint8_t n = std::clamp<uint16_t>(lag_s, 1, max_lag_s);
+        uint16_t sum = 0;
+        for (uint8_t i = 0, idx = step_idx_; i < n; i++) {
+            sum += step_power_[idx];
+            idx = idx == 0 ? max_lag_s - 1 : idx - 1;
+        }
+        lagged_power_ = Q16::fromRatio(sum, n);
+    }
+
+    Anomaly check(const OvenModel& model, Q16 temp_diff, Q16 rate,
+            uint8_t power, uint8_t door_opening, Checks checks) const
+    {
+        Q16 predicted_off = model.calcDtDs(temp_diff, 0, door_opening, 1000);
+        if (power == 0 && lagged_power_ < off_power && rate > predicted_off + ssr_margin)
+            return Anomaly::ssr_stuck_on;
+        if (checks == Checks::ssr_only)
+            return Anomaly::none;
+
+        if (rate < model.calcDtDs(temp_diff, 0, 100, 1000) - probe_margin)
+            return Anomaly::probe_detached;
+
+        Q16 predicted = model.calcDtDs(temp_diff, lagged_power_, door_opening, 1000);
+        Q16 heating = predicted - predicted_off;
+        if (heating >= min_heating && rate < predicted_off + heating / min_heating_div)
+            return Anomaly::no_heating;
+        if (rate < predicted - door_margin)
+            return Anomaly::door_open;
+        return Anomaly::none;
+    }
+};
+
+#endif /* SRC_OVEN_OVEN_MONITOR_H_ */
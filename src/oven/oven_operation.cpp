@@ -1,27 +1,59 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
 #include <misc_math.h>
 #include <oven/oven_operation.h>
 
-bool OvenOperation::startReflow(ReflowProfiles::Profile& profile, OperationCompleteCb reflow_complete_cb)
+static_assert(PidCtrl::sample_early_ms * 2 == OvenOperation::min_control_period_ms);
+
+bool OvenOperation::startReflow(ReflowProfiles::Profile& profile, OperationCompleteCb reflow_complete_cb,
+        ReflowControl control, bool warm_start)
 {
-    if (state_ != State::stopped)
+    BusyGuard guard(busy_);
+    if (oven_.getSensorFault() != 0)
+        return false;
+    if (!isIdle())
         return false;
-    if (oven_.getTemp() >= ReflowProfiles::start_temp)
+    uint16_t oven_temp = oven_.getTemp();
+    if (oven_temp >= ReflowProfiles::start_temp && !warm_start)
         return false;
 
-    operation_complete_cb_ = reflow_complete_cb;
     reflow_op_.init(profile);
+    uint16_t offset_s = 0;
+    if (oven_temp >= ReflowProfiles::start_temp && !reflow_op_.getWarmStartTime(oven_temp, &offset_s))
+        return false;
 
-    // Run at 100% power until profile start temperature
-    state_ = State::reflow_warming;
-    oven_.setDoorOpening(false);
-    oven_.setPowerLevel(100);
+    operation_complete_cb_ = reflow_complete_cb;
+    reflow_ilc_.init(profile);
+    reflow_control_ = control;
+    start_offset_s_ = offset_s;
+    oven_.setDoorOpening(0);
+    monitor_.clear();
+
+    if (oven_temp >= ReflowProfiles::start_temp) {
+        // Join the profile part way through, elapsed time counts from the offset
+        start_time_ms_ = get_millis_func_();
+        state_ = State::reflow_tracking;
+        initPid(oven_temp, oven_.getPowerLevel());
+    }
+    else {
+        // Run at 100% power until profile start temperature. Warming time
+        // counts towards the maximum reflow duration.
+        start_time_ms_ = get_millis_func_();
+        state_ = State::reflow_warming;
+        oven_.setPowerLevel(100);
+    }
+    publishSnapshot(oven_.getTemp());
     return true;
 }
 
 
 bool OvenOperation::startBake(uint16_t time_s, uint16_t temp, OperationCompleteCb bake_complete_cb)
 {
-    if (state_ != State::stopped)
+    BusyGuard guard(busy_);
+    if (oven_.getSensorFault() != 0)
+        return false;
+    if (!isIdle())
         return false;
 
     if (oven_.getTemp() >= temp)
@@ -33,60 +65,173 @@ bool OvenOperation::startBake(uint16_t time_s, uint16_t temp, OperationCompleteC
     operation_complete_cb_ = bake_complete_cb;
     bake_temp_ = temp;
     bake_duration_s_ = time_s;
+    monitor_.clear();
     start_time_ms_ = get_millis_func_();
     state_ = State::baking;
 
-    oven_.setDoorOpening(false);
+    oven_.setDoorOpening(0);
     oven_.setPowerLevel(bake_start_power);
-    pid_algo_.init(oven_.getTemp(), pid_sampling_period_ms / 1000, Libp::PidAlgo::Mode::normal);
+    initPid(oven_.getTemp(), oven_.getPowerLevel());
 
+    publishSnapshot(oven_.getTemp());
     return true;
 }
 
 
 bool OvenOperation::startManualPower(uint8_t power_level)
 {
-    if (state_ != State::stopped && state_ != State::manual_pwr)
+    BusyGuard guard(busy_);
+    if (oven_.getSensorFault() != 0)
+        return false;
+    if (!isIdle() && state_ != State::manual_pwr)
         return false;
 
     if (power_level == 0) {
         stop();
     }
     else {
+        // Only on starting, the level changes with every slider movement
+        if (state_ != State::manual_pwr)
+            monitor_.clear();
         start_time_ms_ = get_millis_func_();
         state_ = State::manual_pwr;
+        oven_.setDoorOpening(0);
         oven_.setPowerLevel(power_level);
     }
+    publishSnapshot(oven_.getTemp());
     return true;
 }
 
 bool OvenOperation::startManualTemp(uint16_t temp)
 {
-    if (state_ != State::stopped && state_ != State::manual_temp)
+    BusyGuard guard(busy_);
+    if (oven_.getSensorFault() != 0)
         return false;
+    if (!isIdle() && state_ != State::manual_temp)
+        return false;
+
+    requested_temp_ = temp;
+    requested_temp_ms_ = get_millis_func_();
+    if (state_ == State::manual_temp)
+        // Setpoint change only, see processState
+        return true;
 
     bake_temp_ = temp;
     bake_duration_s_ = 3600 * 10; // TODO:
+    monitor_.clear();
     start_time_ms_ = get_millis_func_();
     state_ = State::manual_temp;
 
+    oven_.setDoorOpening(0);
     oven_.setPowerLevel(bake_start_power);
-    pid_algo_.init(oven_.getTemp(), pid_sampling_period_ms / 1000, Libp::PidAlgo::Mode::normal);
+    initPid(oven_.getTemp(), oven_.getPowerLevel());
 
+    publishSnapshot(oven_.getTemp());
     return true;
 }
 
 
-bool OvenOperation::isErrorCondition()
+bool OvenOperation::startAutotune(uint16_t temp, OperationCompleteCb autotune_complete_cb)
+{
+    BusyGuard guard(busy_);
+    if (oven_.getSensorFault() != 0)
+        return false;
+    if (!isIdle())
+        return false;
+
+    if (temp < min_autotune_temp || temp > max_autotune_temp)
+        return false;
+
+    if (oven_.getTemp() >= temp)
+        return false;
+
+    operation_complete_cb_ = autotune_complete_cb;
+    bake_temp_ = temp;
+    monitor_.clear();
+    start_time_ms_ = get_millis_func_();
+    state_ = State::autotune;
+
+    oven_.setDoorOpening(0);
+    oven_.setPowerLevel(100);
+    autotune_.init(oven_.getTemp(), autotune_sampling_period_ms, autotune_hysteresis);
+
+    publishSnapshot(oven_.getTemp());
+    return true;
+}
+
+
+bool OvenOperation::setControlPeriod(uint16_t period_ms)
+{
+    BusyGuard guard(busy_);
+    if (!isIdle())
+        return false;
+    if (period_ms < min_control_period_ms || period_ms > max_control_period_ms
+            || period_ms % min_control_period_ms != 0)
+        return false;
+
+    control_period_ms_ = period_ms;
+    return true;
+}
+
+
+bool OvenOperation::getAutotuneResult(PidAutotune::Result* result) const
+{
+    return autotune_.getResult(result);
+}
+
+
+bool OvenOperation::startCharacterization(OperationCompleteCb characterize_complete_cb)
+{
+    BusyGuard guard(busy_);
+    if (oven_.getSensorFault() != 0)
+        return false;
+    if (!isIdle())
+        return false;
+
+    if (oven_.getTemp() > OvenCharacterizer::max_start_temp)
+        return false;
+
+    operation_complete_cb_ = characterize_complete_cb;
+    monitor_.clear();
+    start_time_ms_ = get_millis_func_();
+    state_ = State::characterize;
+
+    oven_.setDoorOpening(0);
+    oven_.setPowerLevel(100);
+    characterizer_.init(oven_.getTemp());
+
+    publishSnapshot(oven_.getTemp());
+    return true;
+}
+
+
+bool OvenOperation::getCharacterizationResult(OvenModel* model) const
+{
+    return characterizer_.getResult(model);
+}
+
+
+bool OvenOperation::isErrorCondition(uint16_t oven_temp)
 {
-    uint16_t oven_temp = oven_.getTemp();
     uint32_t now_ms = get_millis_func_();
     uint16_t elapsed_time_s = (now_ms - start_time_ms_) / 1000;
 
+    // thermocouple fault, SSR already forced off
+    if (oven_.getSensorFault() != 0)
+        return true;
+
+    // oven not responding to the power/door as the model predicts
+    if (monitor_.getAnomaly() != OvenMonitor::Anomaly::none)
+        return true;
+
     // oven too hot/cold
     if (oven_temp < min_oven_temp || oven_temp > max_oven_temp)
         return true;
 
+    // thermocouple stopped converting (sample may be newer than now_ms)
+    if (static_cast<int32_t>(now_ms - oven_.getTempTimestamp()) > max_temp_age_ms)
+        return true;
+
     switch (state_) {
 
     // baking too long
@@ -101,11 +246,20 @@ bool OvenOperation::isErrorCondition()
         if (elapsed_time_s > (max_reflow_duration_s + 30) )
             return true;
         break;
+    case State::autotune:
+        if (elapsed_time_s > (max_autotune_duration_s + 30) )
+            return true;
+        break;
+    case State::characterize:
+        if (elapsed_time_s > (max_characterize_duration_s + 30) )
+            return true;
+        break;
     case State::stopped:
         // TODO: set max manual timer
     case State::manual_pwr:
     case State::manual_temp:
     case State::reflow_cooling:
+    case State::cooldown:
         break;
     }
 
@@ -119,6 +273,53 @@ bool OvenOperation::isErrorCondition()
 static constexpr uint16_t slope_look_ahead_reflow_s = 10;
 static constexpr uint16_t slope_look_ahead_bake_s = 45;
 
+void OvenOperation::initPid(uint16_t oven_temp, Q16 power)
+{
+    bool feed_forward = state_ == State::reflow_tracking && reflow_control_ == ReflowControl::feed_forward;
+    if (feed_forward)
+        pid_ctrl_.setOutputLimits(-ff_correction_range, ff_correction_range);
+    else
+        pid_ctrl_.setOutputLimits(0, 100);
+    // The rate comes from the temperature estimator, filter the derivative
+    // term over about the same time at every control period
+    pid_ctrl_.setFilterTime(max_control_period_ms - control_period_ms_);
+
+    // Bumpless, the first output continues from @p power (of which the
+    // feed-forward provides part)
+    Q16 output = power;
+    if (feed_forward)
+        output -= getFeedForwardPower(oven_temp, getElapsedTime());
+    pid_ctrl_.init(oven_temp, control_period_ms_, PidCtrl::Mode::gradient, output);
+}
+
+
+Q16 OvenOperation::getFeedForwardPower(uint16_t oven_temp, uint16_t elapsed_time_s)
+{
+    // Power applied now reaches the elements on average half a lag later
+    uint16_t time_s = elapsed_time_s + model_->lagSeconds(oven_temp) / 2;
+    uint16_t target_temp = reflow_op_.getReflowTargetTemp(time_s);
+    uint16_t next_temp = reflow_op_.getReflowTargetTemp(time_s + ff_rate_period_s);
+    Q16 target_rate = Q16(static_cast<int32_t>(next_temp) - target_temp) / ff_rate_period_s;
+
+    // Hold the peak until the dwell completes, cooling is handled elsewhere
+    if (reflow_op_.isDwelling() || next_temp < target_temp) {
+        target_temp = reflow_op_.getMaxTemp();
+        target_rate = 0;
+    }
+    return model_->powerForRate(static_cast<int32_t>(target_temp) - nominal_ambient_temp, target_rate);
+}
+
+void OvenOperation::runCoolingUpdate(uint16_t oven_temp, uint16_t elapsed_time_s)
+{
+    // Rate to reach the cooling target a short time ahead, so the door also
+    // corrects any temperature error
+    uint16_t target_temp = reflow_op_.getCoolingTargetTemp(elapsed_time_s + slope_look_ahead_reflow_s);
+    Q16 target_rate = Q16(static_cast<int32_t>(target_temp) - oven_temp) / slope_look_ahead_reflow_s;
+    Q16 opening = model_->doorOpeningForRate(static_cast<int32_t>(oven_temp) - nominal_ambient_temp, target_rate);
+    oven_.setDoorOpening(opening.round());
+}
+
+
 bool OvenOperation::runPidUpdate(uint16_t oven_temp)
 {
     if (state_ != State::baking && state_ != State::manual_temp && state_ != State::reflow_tracking) {
@@ -128,33 +329,93 @@ bool OvenOperation::runPidUpdate(uint16_t oven_temp)
     }
 
     uint16_t elapsed_time_s = getElapsedTime();
-    int16_t target_slope;
-
-    target_slope = (state_ == State::reflow_tracking)
-    		? reflow_op_.getTargetSlope(oven_temp, elapsed_time_s, slope_look_ahead_reflow_s)
-			: (bake_temp_ - oven_temp) / slope_look_ahead_bake_s;
+    bool feed_forward = state_ == State::reflow_tracking && reflow_control_ == ReflowControl::feed_forward;
+    Q16 target_slope = (state_ == State::reflow_tracking)
+            ? reflow_op_.getTargetSlope(oven_temp, elapsed_time_s, slope_look_ahead_reflow_s)
+            : Q16(static_cast<int32_t>(bake_temp_) - oven_temp) / slope_look_ahead_bake_s;
+
+    // The feed forward already anticipates the profile, so the correction
+    // tracks the current target rather than looking ahead. Like the feed
+    // forward it holds the peak if the profile time runs into the cooling
+    // segment before the dwell starts.
+    if (feed_forward && !reflow_op_.isDwelling()) {
+        int32_t target_temp = reflow_op_.getReflowTargetTemp(elapsed_time_s);
+        int32_t next_temp = reflow_op_.getReflowTargetTemp(elapsed_time_s + 1);
+        if (next_temp < target_temp)
+            target_slope = Q16(static_cast<int32_t>(reflow_op_.getMaxTemp()) - oven_temp) / slope_look_ahead_reflow_s;
+        else
+            target_slope = Q16(target_temp - oven_temp) / slope_look_ahead_reflow_s + Q16(next_temp - target_temp);
+    }
 
-    float new_power_lvl;
-    bool pid_has_update = pid_algo_.compute(target_slope, oven_temp, &new_power_lvl);
+    // Feed-forward and learned correction are added to the PID output before
+    // the 0-100% limit. The PID gets the range that is left, so it sees the
+    // power saturate and stops winding up.
+    Q16 added_power = 0;
+    if (feed_forward)
+        added_power = getFeedForwardPower(oven_temp, elapsed_time_s);
+    if (state_ == State::reflow_tracking)
+        added_power += reflow_ilc_.getCorrection(elapsed_time_s);
+    Q16 pid_min = feed_forward ? Q16(-ff_correction_range) : Q16(0);
+    Q16 pid_max = feed_forward ? Q16(ff_correction_range) : Q16(100);
+    pid_min = std::max(pid_min, -added_power);
+    pid_max = std::max(std::min(pid_max, Q16(100) - added_power), pid_min);
+    pid_ctrl_.setOutputLimits(pid_min, pid_max);
+
+    Q16 new_power_lvl;
+    bool pid_has_update = pid_ctrl_.computeFromRate(target_slope, oven_.getTempRate(), &new_power_lvl);
 
     if (pid_has_update) {
-        oven_.setPowerLevel(new_power_lvl);
+        if (state_ == State::reflow_tracking) {
+            int32_t target_temp = reflow_op_.isDwelling()
+                    ? reflow_op_.getMaxTemp()
+                    : reflow_op_.getReflowTargetTemp(elapsed_time_s);
+            reflow_ilc_.addError(elapsed_time_s, target_temp - oven_temp);
+        }
+        new_power_lvl = (new_power_lvl + added_power).clamp(0, 100);
+        oven_.setPowerLevel(new_power_lvl.round());
     }
     return true;
 }
 
 
 bool OvenOperation::process()
+{
+    if (busy_)
+        // Caller interrupted a start/stop. Try again next tick.
+        return state_ != State::stopped;
+
+    oven_.updateDoor();
+    uint16_t oven_temp = oven_.getTemp();
+    updateMonitor(oven_temp);
+    bool running = processState(oven_temp);
+    oven_.setTempAveraging(getTempAveraging(oven_temp));
+    publishSnapshot(oven_temp);
+    return running;
+}
+
+
+void OvenOperation::updateMonitor(uint16_t oven_temp)
+{
+    // Characterization drives the oven outside normal use, and the model
+    // may not fit until it completes
+    OvenMonitor::Checks checks = state_ == State::characterize ? OvenMonitor::Checks::none
+            : isIdle() ? OvenMonitor::Checks::ssr_only : OvenMonitor::Checks::all;
+    monitor_.update(*model_, static_cast<int32_t>(oven_temp) - nominal_ambient_temp,
+            model_->lagSeconds(oven_temp), oven_.getTempRate(),
+            oven_.getPowerLevel(), oven_.getDoorOpening(), checks, get_millis_func_());
+}
+
+
+bool OvenOperation::processState(uint16_t oven_temp)
 {
     if (state_ == State::stopped)
         return true;
 
-    if (isErrorCondition()) {
+    if (isErrorCondition(oven_temp)) {
         stop();
         // TODO: we should alert here
         return false;
     }
-    uint16_t oven_temp = oven_.getTemp();
     uint16_t elapsed_time_s = getElapsedTime();
 
     switch (state_) {
@@ -163,12 +424,16 @@ bool OvenOperation::process()
             // Wait until we hit profile start temperature
             return true;
         start_time_ms_ = get_millis_func_();
-        pid_algo_.init(oven_temp, pid_sampling_period_ms / 1000, Libp::PidAlgo::Mode::gradient);
         state_ = State::reflow_tracking;
+        // Full power while warming is far more than the profile needs, so
+        // continue from the model's power for the initial profile rate
+        initPid(oven_temp, model_->powerForRate(static_cast<int32_t>(oven_temp) - nominal_ambient_temp,
+                reflow_op_.getTargetSlope(oven_temp, 0, slope_look_ahead_reflow_s)));
         break;
     case State::reflow_tracking:
         if (reflow_op_.isFinished(elapsed_time_s)) {
             oven_.setPowerLevel(0);
+            reflow_ilc_.update();
             state_ = State::reflow_cooling;
         }
         else {
@@ -177,20 +442,56 @@ bool OvenOperation::process()
         break;
     case State::reflow_cooling:
         if (oven_temp < ReflowProfiles::end_temp) {
-            operation_complete_cb_();
-            stop();
+            completeOperation();
+            return false;
+        }
+        runCoolingUpdate(oven_temp, elapsed_time_s);
+        break;
+    case State::cooldown:
+        if (oven_temp < ReflowProfiles::start_temp) {
+            oven_.setDoorOpening(0);
+            state_ = State::stopped;
             return false;
         }
-        // TODO: open/close door to control cooling rate
         break;
-    case State::baking:
     case State::manual_temp:
+        if (requested_temp_ != bake_temp_
+                && get_millis_func_() - requested_temp_ms_ >= setpoint_settle_ms)
+            bake_temp_ = requested_temp_;
+        [[fallthrough]];
+    case State::baking:
         if (elapsed_time_s >= bake_duration_s_) {
-            operation_complete_cb_();
-            stop();
+            completeOperation();
             return false;
         }
         else return runPidUpdate(oven_temp);
+    case State::autotune:
+        if (autotune_.isFinished() || elapsed_time_s >= max_autotune_duration_s) {
+            completeOperation();
+            return false;
+        }
+        else {
+            // Same gradient loop as baking so the gains carry over
+            Q16 target_slope = Q16(static_cast<int32_t>(bake_temp_) - oven_temp) / slope_look_ahead_bake_s;
+            uint8_t power_level;
+            if (autotune_.compute(target_slope, oven_temp, &power_level))
+                oven_.setPowerLevel(power_level);
+        }
+        break;
+    case State::characterize:
+        if (characterizer_.isFinished() || elapsed_time_s >= max_characterize_duration_s) {
+            completeOperation();
+            return false;
+        }
+        else {
+            uint8_t power_level;
+            uint8_t door_opening;
+            if (characterizer_.compute(oven_temp, &power_level, &door_opening)) {
+                oven_.setPowerLevel(power_level);
+                oven_.setDoorOpening(door_opening);
+            }
+        }
+        break;
     // suppress unhandled case warning to ensure we catch future ones
     case State::stopped:
     case State::manual_pwr:
@@ -200,9 +501,95 @@ bool OvenOperation::process()
 }
 
 
+void OvenOperation::completeOperation()
+{
+    pending_cb_ = operation_complete_cb_;
+    stop();
+}
+
+
+void OvenOperation::dispatchEvents()
+{
+    OperationCompleteCb cb = pending_cb_;
+    if (cb != nullptr) {
+        pending_cb_ = nullptr;
+        cb();
+    }
+}
+
+
+uint8_t OvenOperation::getTempAveraging(uint16_t oven_temp)
+{
+    bool was_holding = tc_holding_;
+    tc_holding_ = false;
+    switch (state_) {
+    case State::reflow_warming:
+    case State::reflow_cooling:
+    case State::autotune:
+        return ramp_tc_averaging;
+    case State::reflow_tracking:
+        return reflow_op_.isDwelling() ? hold_tc_averaging : ramp_tc_averaging;
+    case State::baking:
+    case State::manual_temp:
+        // Separate bands so a temperature swinging around one edge doesn't
+        // keep reconfiguring the thermocouple
+        tc_holding_ = abs(static_cast<int32_t>(bake_temp_) - oven_temp)
+                < (was_holding ? hold_leave_band : hold_enter_band);
+        return tc_holding_ ? hold_tc_averaging : ramp_tc_averaging;
+    case State::stopped:
+    case State::manual_pwr:
+    case State::characterize:
+    case State::cooldown:
+    default:
+        return default_tc_averaging;
+    }
+}
+
+
+void OvenOperation::publishSnapshot(uint16_t oven_temp)
+{
+    snapshot_seq_ = snapshot_seq_ + 1;
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+    snapshot_.state = state_;
+    snapshot_.power_level = oven_.getPowerLevel();
+    snapshot_.temp = oven_temp;
+    snapshot_.temp_rate = oven_.getTempRate().round();
+    snapshot_.elapsed_s = getElapsedTime();
+    snapshot_.start_offset_s = start_offset_s_;
+    snapshot_.sensor_fault = oven_.getSensorFault();
+    snapshot_.anomaly = monitor_.getAnomaly();
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+    snapshot_seq_ = snapshot_seq_ + 1;
+}
+
+
+OvenOperation::Snapshot OvenOperation::getSnapshot() const
+{
+    Snapshot snapshot;
+    uint32_t seq;
+    do {
+        seq = snapshot_seq_;
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+        snapshot = snapshot_;
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+    } while ((seq & 1) || seq != snapshot_seq_);
+    return snapshot;
+}
+
+
 void OvenOperation::stop()
 {
+    BusyGuard guard(busy_);
     oven_.setPowerLevel(0);
-    oven_.setDoorOpening(true);
-    state_ = State::stopped;
+    start_offset_s_ = 0;
+    // Cool as fast as possible so the oven is ready for the next run
+    if (oven_.getTemp() >= ReflowProfiles::start_temp) {
+        oven_.setDoorOpening(100);
+        state_ = State::cooldown;
+    }
+    else {
+        oven_.setDoorOpening(0);
+        state_ = State::stopped;
+    }
+    publishSnapshot(oven_.getTemp());
 }
@@ -2,14 +2,23 @@
 #define REFLOW_REFLOW_OPERATION_H_
 
 #include <oven/oven_hardware.h>
-#include <pid/pid_algo.h>
+#include "oven/pid_ctrl.h"
+#include "oven/pid_autotune.h"
+#include "oven/oven_characterizer.h"
+#include "oven/oven_monitor.h"
 #include <cstdint>
 #include "reflow/reflow_profiles.h"
 #include "reflow/reflow_operation.h"
+#include "reflow/reflow_ilc.h"
 #include "libpekin.h"
 
 /**
  * State machine to manage execution of reflow/baking operations.
+ *
+ * @p process is intended to be called from the control timer interrupt while
+ * the remaining functions are called from the UI loop. Completion callbacks
+ * are deferred to @p dispatchEvents and state is handed to the UI via
+ * @p getSnapshot.
  */
 class OvenOperation {
 
@@ -24,7 +33,35 @@ public:
         manual_temp,     /**< Fixed temp forever */
         reflow_warming,  /**< Running at 100% pwr until reflow start temp. */
         reflow_tracking, /**< Following reflow profile */
-        reflow_cooling   /**< Cooling 0% pwr with door after reflow */
+        reflow_cooling,  /**< Cooling 0% pwr with door after reflow */
+        autotune,        /**< Relay experiment to measure PID gains */
+        characterize,    /**< Power steps to measure the oven model */
+        cooldown         /**< Door open at 0% pwr until reflow start temp. */
+    };
+
+    /// Reflow profile tracking method
+    enum class ReflowControl : uint8_t {
+        pid,         /**< PID on the slope to the profile a fixed time ahead */
+        feed_forward /**< Oven model power for the profile plus PID correction */
+    };
+
+    /// Consistent copy of the operation state for display.
+    struct Snapshot {
+        State state;
+        /// Power level percentage
+        uint8_t power_level;
+        /// Estimated temperature in 0.1°C
+        uint16_t temp;
+        /// Estimated rate of change in 0.1°C/s
+        int16_t temp_rate;
+        /// Seconds since operation start (profile time when reflowing)
+        uint16_t elapsed_s;
+        /// Profile time skipped by a warm start
+        uint16_t start_offset_s;
+        /// Latched thermocouple fault (@p TcFault bits), 0 = none
+        uint8_t sensor_fault;
+        /// Hardware problem detected by the model, held until the next start
+        OvenMonitor::Anomaly anomaly;
     };
 
     // 0.1°C units
@@ -32,9 +69,18 @@ public:
     inline static constexpr uint16_t max_bake_temp = 1300;
     inline static constexpr uint16_t max_bake_duration_s = 60 * 60 * 10;
     inline static constexpr uint16_t max_reflow_duration_s = 60 * 12;
+    inline static constexpr uint16_t min_autotune_temp = 1200;
+    inline static constexpr uint16_t max_autotune_temp = 2500;
+    inline static constexpr uint16_t max_autotune_duration_s = 60 * 60;
+    inline static constexpr uint16_t max_characterize_duration_s = 60 * 45;
+    /// Control period limits. The period must be a multiple of the minimum,
+    /// which is the rate @p process is called at.
+    inline static constexpr uint16_t min_control_period_ms = 100;
+    inline static constexpr uint16_t max_control_period_ms = 1000;
 
-    OvenOperation(OvenHardware& oven, Libp::PidAlgo& pid_algo, GetMillisFunc get_millis_func)
-            : oven_(oven), pid_algo_(pid_algo), get_millis_func_(get_millis_func)
+    OvenOperation(OvenHardware& oven, PidCtrl& pid_ctrl, GetMillisFunc get_millis_func)
+            : oven_(oven), pid_ctrl_(pid_ctrl), get_millis_func_(get_millis_func),
+              autotune_(0, 100, get_millis_func), characterizer_(get_millis_func)
     { };
 
     /**
@@ -43,11 +89,16 @@ public:
      * @param profile
      * @param reflow_complete_cb function to call on successful completion (not
      *                           called if stopped early). May be null.
+     * @param control profile tracking method
+     * @param warm_start if the oven is above the profile start temperature,
+     *                   join the preheat/soak where it reaches the current
+     *                   temperature instead of failing
      *
      * @return @arg true if profile is started successfully.
      *         @arg false if reflow/bake already running or oven too hot.
      */
-    bool startReflow(ReflowProfiles::Profile& profile, OperationCompleteCb reflow_complete_cb);
+    bool startReflow(ReflowProfiles::Profile& profile, OperationCompleteCb reflow_complete_cb,
+            ReflowControl control = ReflowControl::pid, bool warm_start = false);
 
     /**
      * Begin bake operation. Once started, \p process MUST be called regularly.
@@ -66,12 +117,75 @@ public:
     bool startBake(uint16_t time_s, uint16_t temp, OperationCompleteCb bake_complete_cb);
 
     bool startManualPower(uint8_t power_level);
+
+    /**
+     * Hold a temperature. If already holding, the new temperature is applied
+     * once it has been unchanged for @p setpoint_settle_ms (e.g. while a
+     * slider is dragged), without resetting the controller.
+     *
+     * @param temp temperature in 0.1°C
+     */
     bool startManualTemp(uint16_t temp);
 
+    /**
+     * Begin a relay feedback experiment around @p temp to measure the
+     * ultimate gain/period of the gradient control loop. Once started,
+     * \p process MUST be called regularly.
+     *
+     * @param temp temperature in tenths of a degrees Celcius. Must be between
+     *             @p min_autotune_temp and @p max_autotune_temp.
+     * @param autotune_complete_cb function to call when the experiment ends
+     *                             (not called if stopped early). Use
+     *                             @p getAutotuneResult to check the outcome.
+     *                             May be null.
+     *
+     * @return @arg true if the experiment is started successfully.
+     *         @arg false if an operation is already running, the oven is too
+     *                    hot, or @p temp is out of range.
+     */
+    bool startAutotune(uint16_t temp, OperationCompleteCb autotune_complete_cb);
+
+    /**
+     * @param result receives the outcome of the last autotune experiment
+     *
+     * @return false if the experiment did not produce a valid result
+     */
+    bool getAutotuneResult(PidAutotune::Result* result) const;
+
+    /**
+     * Begin an oven characterization run (see @p OvenCharacterizer). The
+     * oven must be near ambient temperature. Once started, \p process MUST
+     * be called regularly.
+     *
+     * @param characterize_complete_cb function to call when the run ends (not
+     *                                 called if stopped early). Use
+     *                                 @p getCharacterizationResult to check
+     *                                 the outcome. May be null.
+     *
+     * @return @arg true if the run is started successfully.
+     *         @arg false if an operation is already running or the oven is
+     *                    too hot.
+     */
+    bool startCharacterization(OperationCompleteCb characterize_complete_cb);
+
+    /// Current step of the characterization run. Safe to call from the UI.
+    OvenCharacterizer::Phase getCharacterizationPhase() const
+    {
+        return characterizer_.getPhase();
+    }
+
+    /**
+     * @param model receives the model fitted by the last characterization run
+     *
+     * @return false if the run did not produce a valid model
+     */
+    bool getCharacterizationResult(OvenModel* model) const;
+
     /**
      * Update running state and oven output for a reflow/bake operation. Must
-     * be called regularly (< pid_sampling_period) when an operation is
-     * running.
+     * be called every @p min_control_period_ms. Safe to call from an
+     * interrupt that preempts the other member functions; the pass is
+     * skipped if one of them is in progress.
      *
      * @return @arg true if reflow/bake is still running.
      *         @arg false if not reflowing or baking.
@@ -79,44 +193,167 @@ public:
     bool process();
 
     /**
-     * Stop reflow/bake operation. Oven power will be turned off and door will
-     * be opened.
+     * Call completion callbacks raised by @p process. Call regularly from
+     * the UI loop.
+     */
+    void dispatchEvents();
+
+    /// True if a completion callback is waiting for @p dispatchEvents
+    bool isEventPending() const { return pending_cb_ != nullptr; }
+
+    /**
+     * Return the state published by the latest call to @p process, or by a
+     * start/stop function so the caller sees the new state immediately.
+     *
+     * Must not be called from an interrupt with a higher priority than the
+     * one calling @p process.
+     */
+    Snapshot getSnapshot() const;
+
+    /**
+     * Stop reflow/bake operation. Oven power will be turned off and the door
+     * opened until the oven has cooled below the reflow start temperature
+     * (@p State::cooldown). New operations may be started during cooldown.
      */
     void stop();
 
     State getState() { return state_; }
 
+    /**
+     * Set the thermal model used for feed-forward control and to check the
+     * oven responds as expected.
+     *
+     * @param model must outlive this object. Must not be modified while an
+     *              operation is running.
+     */
+    void setOvenModel(const OvenModel& model) { model_ = &model; }
+
+    /**
+     * Set the PID sampling period used for reflow/bake/manual temperature
+     * control.
+     *
+     * @param period_ms multiple of @p min_control_period_ms, up to
+     *                  @p max_control_period_ms
+     *
+     * @return false if an operation is running or @p period_ms is invalid
+     */
+    bool setControlPeriod(uint16_t period_ms);
+
+    uint16_t getControlPeriod() const { return control_period_ms_; }
+
     uint16_t getElapsedTime()
     {
         return state_ == State::stopped
-                ? 0 : (get_millis_func_() - start_time_ms_) / 1000;
+                ? 0 : (get_millis_func_() - start_time_ms_) / 1000 + start_offset_s_;
     }
 
 private:
-    inline static constexpr uint16_t pid_sampling_period_ms = 1000;
+    inline static constexpr uint16_t autotune_sampling_period_ms = 1000;
     inline static constexpr uint8_t bake_start_power = 50;
     /// Stop all operations if we exceed this temperature
     inline static constexpr uint16_t max_oven_temp = 2800; // units = 0.1C
     /// At less than this value we'll assume a thermocouple malfunction
     inline static constexpr uint16_t min_oven_temp = 50; // units = 0.1C
+    /// If no new thermocouple conversion arrives within this time we'll
+    /// assume DRDY/SPI has failed (nominal conversion period is < 500ms)
+    inline static constexpr uint16_t max_temp_age_ms = 2000;
+    /// Relay hysteresis for autotune in 0.1°C/s, must exceed the slope noise
+    inline static constexpr uint8_t autotune_hysteresis = 2;
+    /// Feed-forward rate is taken over this period of the profile
+    inline static constexpr uint8_t ff_rate_period_s = 10;
+    /// Model rates are relative to ambient, assume a typical room
+    inline static constexpr uint16_t nominal_ambient_temp = 250;
+    /// PID output range for correcting the feed-forward power
+    inline static constexpr uint8_t ff_correction_range = 30;
+    /// Thermocouple averaging while ramping, where latency matters most
+    inline static constexpr uint8_t ramp_tc_averaging = 1;
+    /// Thermocouple averaging while holding a temperature
+    inline static constexpr uint8_t hold_tc_averaging = 16;
+    /// Bake/manual temperature is held once within @p hold_enter_band of the
+    /// target, until further than @p hold_leave_band from it (0.1°C)
+    inline static constexpr uint8_t hold_enter_band = 50;
+    inline static constexpr uint8_t hold_leave_band = 100;
+    /// Live manual temperature changes apply once unchanged for this long
+    inline static constexpr uint16_t setpoint_settle_ms = 500;
 
     OvenHardware& oven_;
-    Libp::PidAlgo& pid_algo_;
+    PidCtrl& pid_ctrl_;
     const GetMillisFunc get_millis_func_;
 
     State state_ = State::stopped;
     /// Start time for reflow/bake/manual
     uint32_t start_time_ms_ = 0;
+    uint16_t start_offset_s_ = 0;
+    uint16_t control_period_ms_ = max_control_period_ms;
     uint16_t bake_duration_s_ = 0;
     uint16_t bake_temp_ = 0;
+    /// Manual temperature requested while running, and when
+    uint16_t requested_temp_ = 0;
+    uint32_t requested_temp_ms_ = 0;
+    /// Within the bake/manual hold band, see @p getTempAveraging
+    bool tc_holding_ = false;
     ReflowOperation reflow_op_;
+    ReflowIlc reflow_ilc_;
+    ReflowControl reflow_control_ = ReflowControl::pid;
+    const OvenModel* model_ = &default_oven_model;
+    OvenMonitor monitor_;
+    PidAutotune autotune_;
+    OvenCharacterizer characterizer_;
     OperationCompleteCb operation_complete_cb_ = nullptr;
+    /// Completion callback waiting for @p dispatchEvents
+    volatile OperationCompleteCb pending_cb_ = nullptr;
+
+    /// True while a public member function other than @p process is running
+    volatile bool busy_ = false;
+    /// Incremented before and after each snapshot update (odd = updating)
+    volatile uint32_t snapshot_seq_ = 0;
+    Snapshot snapshot_ = { };
+
+    /// Marks the operation busy for the lifetime of the object.
+    class BusyGuard {
+    public:
+        BusyGuard(volatile bool& busy) : busy_(busy), prev_(busy) { busy_ = true; }
+        ~BusyGuard() { busy_ = prev_; }
+    private:
+        volatile bool& busy_;
+        const bool prev_;
+    };
 
+    void updateMonitor(uint16_t oven_temp);
+    bool processState(uint16_t oven_temp);
+    void completeOperation();
+    void publishSnapshot(uint16_t oven_temp);
+
+    bool isIdle() const { return state_ == State::stopped || state_ == State::cooldown; }
+    /**
+     * @param oven_temp current oven temperature in 0.1°C
+     *
+     * @return thermocouple conversions to average in the current state
+     */
+    uint8_t getTempAveraging(uint16_t oven_temp);
+    /// @param power total power to continue from
+    void initPid(uint16_t oven_temp, Q16 power);
     bool runPidUpdate(uint16_t oven_temp);
     /**
+     * @param oven_temp current oven temperature in 0.1°C
+     * @param elapsed_time_s elapsed profile time
+     *
+     * @return model power level that follows the profile
+     */
+    Q16 getFeedForwardPower(uint16_t oven_temp, uint16_t elapsed_time_s);
+    /**
+     * Set the door opening to follow the profile cooling rate.
+     *
+     * @param oven_temp current oven temperature in 0.1°C
+     * @param elapsed_time_s elapsed profile time
+     */
+    void runCoolingUpdate(uint16_t oven_temp, uint16_t elapsed_time_s);
+    /**
+     * @param oven_temp current oven temperature in 0.1°C
+     *
      * @return true if an error is detected and the oven should be turned off.
      */
-    bool isErrorCondition();
+    bool isErrorCondition(uint16_t oven_temp);
 };
 
 #endif /* REFLOW_REFLOW_OPERATION_H_ */
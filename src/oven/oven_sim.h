@@ -4,76 +4,115 @@
 #include <cstdint>
 #include <algorithm>
 #include <cstring>
-#include "libpekin.h"
-
-// Cooling (0.1deg C)
-// dT/ds = m*temp + b
-
-static inline constexpr float cool_m = -.002115;
-static inline constexpr float cool_b =  .6675;
-
-// Heating (0.1deg C)
-// dT/ds = m*temp + b
-
-static inline constexpr float heat_m = -.0015;
-static inline constexpr float heat_b = 25;
-static inline constexpr float max_heat_rate = 25;
-
-// Power adj. for heating
-// dT/ds = dT/ds(100%) * pwr/100 * pwr_adj
-// factor = m*pwr + b
-
-static inline constexpr float pwr_m =  .002;
-static inline constexpr float pwr_b =  .80;
-
-inline
-float calc_dt_ds(float temp_diff, float power, uint16_t millis)
-{
-    float cool_dtds = cool_m * temp_diff + cool_b;
-    float heat_dtds = heat_m * temp_diff + heat_b;
-    float pwr_adj = power/100 * (power*pwr_m + pwr_b);
-    heat_dtds *= pwr_adj;
-    heat_dtds = std::min(heat_dtds, max_heat_rate);
-    return (cool_dtds + heat_dtds) * millis / 1000;
-}
-
-static inline constexpr uint16_t max_avg_len = 200;
-static float avg_dat[max_avg_len] = { 0 };
-static float movingAvg(double new_data, uint16_t n)
-{
-    memmove(&avg_dat[1], &avg_dat[0], (max_avg_len - 1) * sizeof(uint16_t));
-    avg_dat[0] = new_data;
-
-    float avg_sum = 0;
-    int16_t i = n - 1;
-    while (i >= 0)
-        avg_sum += avg_dat[i--];
-
-    return avg_sum / n;
-}
-
-static float ambient_temp = 270;
-static float mock_temp = ambient_temp;
-static uint64_t last_instant = 0;
-static void updateMockTemp(uint8_t power_lvl, uint16_t elapsed_ms)
-{
-    uint16_t avg_len = std::max(15., (double)(1700 - mock_temp) / 20);
-    float lagged_power = movingAvg(power_lvl, avg_len); // 150
-    float dt_ds = calc_dt_ds(mock_temp - ambient_temp, lagged_power, elapsed_ms);
-    mock_temp += dt_ds;
-}
-
-static float getMockTemp(uint8_t power_lvl)
-{
-    if (last_instant == 0)
-        last_instant = Libp::getMillis();
-    uint64_t now = Libp::getMillis();
-    uint16_t elapsed_ms = now - last_instant;
-    if (elapsed_ms >= 1000) {
-        updateMockTemp(power_lvl, elapsed_ms);
-        last_instant = now;
+#include "fixed_point.h"
+#include "oven/oven_model.h"
+
+/**
+ * Simulated oven used in place of the SSR/thermocouple hardware, driven by an
+ * @p OvenModel.
+ *
+ * The model is stepped once per simulated second using the supplied clock, so
+ * it runs equally well against the real-time clock on target or a virtual
+ * clock on the host.
+ */
+class OvenSim {
+public:
+    using GetMillisFunc = uint64_t (*)();
+
+    /**
+     * @param get_millis_func simulation clock
+     * @param model thermal model, must outlive the simulation
+     * @param ambient_temp starting/ambient temperature in 0.1°C
+     */
+    OvenSim(GetMillisFunc get_millis_func, const OvenModel& model = default_oven_model,
+            uint16_t ambient_temp = 270)
+            : get_millis_func_(get_millis_func), model_(model),
+              ambient_temp_(ambient_temp), temp_(ambient_temp)
+    { }
+
+    /// The model sees the average power over each step, so power may be
+    /// changed more often than once a step
+    void setPowerLevel(uint8_t percentage)
+    {
+        accumulatePower(get_millis_func_());
+        power_lvl_ = percentage;
+    }
+    uint8_t getPowerLevel() const          { return power_lvl_; }
+
+    void setDoorOpening(uint8_t opening)   { door_opening_ = opening; }
+
+    uint64_t getMillis() const { return get_millis_func_(); }
+
+    /// Time of the latest model step, i.e. when the temperature last changed
+    uint64_t getSampleTime() const { return last_instant_; }
+
+    /**
+     * Advance the model to the current clock time and return the
+     * temperature in 0.1°C.
+     */
+    uint16_t getTemp()
+    {
+        uint64_t now = get_millis_func_();
+        if (!started_) {
+            last_instant_ = now;
+            power_instant_ = now;
+            started_ = true;
+        }
+        while (now - last_instant_ >= step_ms) {
+            last_instant_ += step_ms;
+            accumulatePower(last_instant_);
+            update(step_ms);
+            power_ms_ = 0;
+        }
+        return temp_.round();
+    }
+
+private:
+    static constexpr uint16_t step_ms = 1000;
+    static constexpr uint16_t max_avg_len = 200;
+
+    const GetMillisFunc get_millis_func_;
+    const OvenModel& model_;
+    const Q16 ambient_temp_;
+    Q16 temp_;
+    uint8_t power_lvl_ = 0;
+    uint8_t door_opening_ = 0;
+    bool started_ = false;
+    uint64_t last_instant_ = 0;
+    /// Power level percentage * ms applied since the start of the step
+    uint32_t power_ms_ = 0;
+    uint64_t power_instant_ = 0;
+    uint8_t avg_dat_[max_avg_len] = { 0 };
+
+    /// Heater element lag: average of the last @p n power levels
+    Q16 movingAvg(uint8_t new_data, uint16_t n)
+    {
+        memmove(&avg_dat_[1], &avg_dat_[0], (max_avg_len - 1) * sizeof(avg_dat_[0]));
+        avg_dat_[0] = new_data;
+
+        uint32_t avg_sum = 0;
+        int16_t i = n - 1;
+        while (i >= 0)
+            avg_sum += avg_dat_[i--];
+
+        return Q16::fromRatio(avg_sum, n);
+    }
+
+    void accumulatePower(uint64_t until)
+    {
+        if (started_ && until > power_instant_) {
+            power_ms_ += power_lvl_ * static_cast<uint32_t>(until - power_instant_);
+            power_instant_ = until;
+        }
+    }
+
+    void update(uint16_t elapsed_ms)
+    {
+        uint8_t step_power = std::min<uint32_t>((power_ms_ + elapsed_ms / 2) / elapsed_ms, 100);
+        uint16_t avg_len = std::clamp<uint16_t>(model_.lagSeconds(temp_.floor()), 1, max_avg_len);
+        Q16 lagged_power = movingAvg(step_power, avg_len);
+        temp_ += model_.calcDtDs(temp_ - ambient_temp_, lagged_power, door_opening_, elapsed_ms);
     }
-    return mock_temp;
-}
+};
 
 #endif /* OVEN_SIM_H_ */
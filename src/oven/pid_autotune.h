@@ -0,0 +1,203 @@
+#ifndef SRC_OVEN_PID_AUTOTUNE_H_
+#define SRC_OVEN_PID_AUTOTUNE_H_
+
+#include <cstdint>
+#include "fixed_point.h"
+
+/**
+ * Relay feedback (Åström–Hägglund) PID autotuner.
+ *
+ * The output is switched between bias + d and bias - d each time the error
+ * crosses a hysteresis band, which drives the loop into a limit cycle. The
+ * bias is adjusted after each cycle until the high and low times are equal so
+ * the limit cycle is symmetrical about the operating point. The ultimate gain
+ * is then Ku = 4d / (pi * sqrt(a^2 - h^2)) where d is the relay amplitude, a
+ * the error amplitude and h the hysteresis, and the ultimate period Pu is the
+ * limit cycle period. Gains are derived with the Ziegler–Nichols rules.
+ *
+ * Units match @p PidCtrl: error is 0.1°C in normal mode and 0.1°C/s in
+ * gradient mode, resulting gains are in tenths.
+ */
+class PidAutotune {
+public:
+    using GetMillisFunc = uint64_t (*)();
+
+    struct Result {
+        /// Ultimate gain, % output per unit of error
+        Q16 ku;
+        /// Ultimate period in seconds
+        Q16 pu_s;
+        /// Gains in tenths (@p PidCtrl units)
+        uint16_t kp;
+        uint16_t ki;
+        uint16_t kd;
+    };
+
+    PidAutotune(uint8_t out_min, uint8_t out_max, GetMillisFunc get_millis_func)
+            : out_min_(out_min), out_max_(out_max), get_millis_func_(get_millis_func)
+    { }
+
+    /**
+     * Reset tuner state. Call before starting to compute outputs.
+     *
+     * @param input current process input
+     * @param sampling_period_ms minimum interval between output updates
+     * @param hysteresis relay hysteresis in error units. Should exceed the
+     *                   measurement noise.
+     */
+    void init(uint16_t input, uint16_t sampling_period_ms, Q16 hysteresis)
+    {
+        sampling_period_ms_ = sampling_period_ms;
+        hysteresis_ = hysteresis;
+        last_time_ms_ = get_millis_func_();
+        last_input_ = input;
+        relay_high_ = true;
+        bias_ = (out_min_ + out_max_) / 2;
+        d_ = (out_max_ - out_min_) / 2;
+        cycles_ = 0;
+        cycle_started_ = false;
+        cycle_start_ms_ = 0;
+        switch_ms_ = 0;
+        high_ms_ = 0;
+        err_max_ = 0;
+        err_min_ = 0;
+        amplitude_sum_ = 0;
+        d_sum_ = 0;
+        period_sum_ms_ = 0;
+    }
+
+    /**
+     * Compute a new output if at least one sampling period has elapsed since
+     * the previous output.
+     *
+     * @param setpoint as per @p PidCtrl::compute in gradient mode (rate)
+     * @param input current temperature
+     * @param output receives the new output if one is computed
+     *
+     * @return true if @p output was updated
+     */
+    bool compute(Q16 setpoint, uint16_t input, uint8_t* output)
+    {
+        uint64_t now = get_millis_func_();
+        uint32_t dt_ms = now - last_time_ms_;
+        if (dt_ms < sampling_period_ms_)
+            return false;
+        last_time_ms_ = now;
+
+        Q16 pv = Q16::fromRatio((static_cast<int32_t>(input) - last_input_) * 1000, dt_ms);
+        last_input_ = input;
+        Q16 err = setpoint - pv;
+
+        if (err > err_max_)
+            err_max_ = err;
+        if (err < err_min_)
+            err_min_ = err;
+
+        if (relay_high_ && err < -hysteresis_) {
+            relay_high_ = false;
+            high_ms_ = now - switch_ms_;
+            switch_ms_ = now;
+        }
+        else if (!relay_high_ && err > hysteresis_) {
+            // Rising switch marks the end of a full cycle
+            relay_high_ = true;
+            if (cycle_started_ && cycles_ < total_cycles) {
+                if (cycles_ >= settle_cycles) {
+                    amplitude_sum_ += (err_max_ - err_min_) / 2;
+                    d_sum_ += d_;
+                    period_sum_ms_ += now - cycle_start_ms_;
+                }
+                cycles_++;
+                adjustBias(high_ms_, now - switch_ms_);
+            }
+            cycle_started_ = true;
+            cycle_start_ms_ = now;
+            switch_ms_ = now;
+            err_max_ = err;
+            err_min_ = err;
+        }
+        *output = relay_high_ ? bias_ + d_ : bias_ - d_;
+        return true;
+    }
+
+    /// True once enough limit cycles have been measured
+    bool isFinished() const { return cycles_ >= total_cycles; }
+
+    /**
+     * @param result receives the measured ultimate gain/period and derived
+     *               gains
+     *
+     * @return false if not finished or the measurement was invalid
+     */
+    bool getResult(Result* result) const
+    {
+        static constexpr uint8_t measured_cycles = total_cycles - settle_cycles;
+        static constexpr Q16 pi = Q16::fromFloat(3.14159265);
+
+        if (!isFinished())
+            return false;
+
+        Q16 amplitude = amplitude_sum_ / measured_cycles;
+        if (amplitude <= hysteresis_)
+            return false;
+
+        // sqrt(a^2 - h^2) by Newton's method, a is a good initial estimate
+        Q16 sq = amplitude * amplitude - hysteresis_ * hysteresis_;
+        Q16 root = amplitude;
+        for (uint8_t i = 0; i < 8; i++)
+            root = (root + sq / root) / 2;
+
+        Q16 relay_amplitude = Q16::fromRatio(d_sum_, measured_cycles);
+        result->ku = relay_amplitude * 4 / (pi * root);
+        result->pu_s = Q16::fromRatio(period_sum_ms_ / measured_cycles, 1000);
+
+        // Ziegler–Nichols (Kp = 0.6Ku, Ki = 1.2Ku/Pu, Kd = 0.075KuPu) in tenths
+        result->kp = (result->ku * 6).round();
+        result->ki = (result->ku * 12 / result->pu_s).round();
+        result->kd = (result->ku * result->pu_s * 3 / 4).round();
+        return true;
+    }
+
+private:
+    /// Cycles discarded while the limit cycle establishes itself
+    static constexpr uint8_t settle_cycles = 4;
+    static constexpr uint8_t total_cycles = settle_cycles + 4;
+    /// Smallest relay amplitude the bias adjustment may leave
+    static constexpr uint8_t min_d = 10;
+
+    const uint8_t out_min_;
+    const uint8_t out_max_;
+    const GetMillisFunc get_millis_func_;
+
+    uint16_t sampling_period_ms_ = 1000;
+    Q16 hysteresis_;
+    uint64_t last_time_ms_ = 0;
+    uint16_t last_input_ = 0;
+    bool relay_high_ = true;
+    uint8_t bias_ = 0;
+    uint8_t d_ = 0;
+    uint8_t cycles_ = 0;
+    bool cycle_started_ = false;
+    uint64_t cycle_start_ms_ = 0;
+    uint64_t switch_ms_ = 0;
+    uint32_t high_ms_ = 0;
+    Q16 err_max_;
+    Q16 err_min_;
+    Q16 amplitude_sum_;
+    uint16_t d_sum_ = 0;
+    uint32_t period_sum_ms_ = 0;
+
+    /// Long high times mean the bias is below the holding power, and vice versa
+    void adjustBias(uint32_t high_ms, uint32_t low_ms)
+    {
+        int32_t shift = static_cast<int32_t>(d_) * (static_cast<int32_t>(high_ms) - static_cast<int32_t>(low_ms))
+                / static_cast<int32_t>(high_ms + low_ms);
+        int32_t bias = bias_ + shift;
+        bias = bias < out_min_ + min_d ? out_min_ + min_d
+                : bias > out_max_ - min_d ? out_max_ - min_d : bias;
+        bias_ = bias;
+        d_ = bias_ - out_min_ < out_max_ - bias_ ? bias_ - out_min_ : out_max_ - bias_;
+    }
+};
+
+#endif /* SRC_OVEN_PID_AUTOTUNE_H_ */
@@ -0,0 +1,212 @@
+#ifndef SRC_OVEN_PID_CTRL_H_
+#define SRC_OVEN_PID_CTRL_H_
+
+#include <cstdint>
+#include <algorithm>
+#include "fixed_point.h"
+
+/**
+ * Fixed point PID controller.
+ *
+ * Gains are specified in tenths (e.g. kp = 40 -> 4.0 % output per unit of
+ * error). Error units are 0.1°C in normal mode and 0.1°C/s in gradient mode.
+ * Time is in seconds for the integral and derivative terms.
+ *
+ * The derivative term acts on the measurement rather than the error to avoid
+ * output spikes on setpoint changes, so the setpoint may be changed between
+ * samples without @p init. The integral term is clamped to the output range
+ * and, while the output saturates, tracked back towards the value holding
+ * the output at the limit (back-calculation, tracking time = kp/ki) so it
+ * doesn't wind up.
+ *
+ * @p init may be given the output currently applied, in which case the
+ * first computed output continues from it (bumpless transfer).
+ *
+ * At short sampling periods the thermocouple noise and resolution dominate
+ * the differences between samples, so the derivative term (and in gradient
+ * mode the measured rate, itself a derivative) can be passed through a
+ * first order low pass filter, see @p setFilterTime.
+ */
+class PidCtrl {
+public:
+    using GetMillisFunc = uint64_t (*)();
+
+    /// A sample up to this early is still taken. A tick delayed by a higher
+    /// priority interrupt or a millisecond boundary otherwise pushes the
+    /// sample a whole tick late. Half the shortest control tick
+    /// (@p OvenOperation::min_control_period_ms).
+    inline static constexpr uint16_t sample_early_ms = 50;
+
+    enum class Mode : uint8_t {
+        normal,  /**< Setpoint and input are temperatures */
+        gradient /**< Setpoint is a rate (0.1°C/s), input is a temperature */
+    };
+
+    PidCtrl(uint16_t kp, uint16_t ki, uint16_t kd,
+            uint8_t out_min, uint8_t out_max, GetMillisFunc get_millis_func)
+            : out_min_(out_min), out_max_(out_max), get_millis_func_(get_millis_func)
+    {
+        setPidParams(kp, ki, kd);
+    }
+
+    /**
+     * Output range, e.g. a symmetric range when correcting a feed-forward.
+     * When other terms are added to the output before the actuator limits it,
+     * set the range left for the PID before each compute so anti-windup
+     * sees the actuator saturate.
+     */
+    void setOutputLimits(Q16 out_min, Q16 out_max)
+    {
+        out_min_ = out_min;
+        out_max_ = out_max;
+    }
+
+    void setPidParams(uint16_t kp, uint16_t ki, uint16_t kd)
+    {
+        kp_ = Q16::fromRatio(kp, gain_scale);
+        ki_ = Q16::fromRatio(ki, gain_scale);
+        kd_ = Q16::fromRatio(kd, gain_scale);
+    }
+
+    /**
+     * Set the time constant of the derivative/rate filter. 0 disables the
+     * filter. Takes effect on the next @p init.
+     */
+    void setFilterTime(uint16_t filter_ms) { filter_ms_ = filter_ms; }
+
+    /**
+     * Reset controller state. Call before starting to compute outputs.
+     *
+     * @param input current process input
+     * @param sampling_period_ms minimum interval between output updates
+     * @param mode
+     * @param output output currently applied. The integral term is set on
+     *               the first sample so the output continues from it.
+     */
+    void init(uint16_t input, uint16_t sampling_period_ms, Mode mode, Q16 output = 0)
+    {
+        mode_ = mode;
+        sampling_period_ms_ = sampling_period_ms;
+        last_time_ms_ = get_millis_func_();
+        last_input_ = input;
+        last_pv_ = mode == Mode::gradient ? Q16(0) : Q16(input);
+        integral_ = output.clamp(out_min_, out_max_);
+        deriv_ = 0;
+        first_sample_ = true;
+        // Samples are evenly spaced so the filter coefficient is fixed
+        filter_alpha_ = Q16::fromRatio(sampling_period_ms, sampling_period_ms + filter_ms_);
+    }
+
+    /**
+     * Compute a new output if at least one sampling period has elapsed since
+     * the previous output.
+     *
+     * @param setpoint temperature (normal) or rate (gradient)
+     * @param input current temperature
+     * @param output receives the new output if one is computed
+     *
+     * @return true if @p output was updated
+     */
+    bool compute(Q16 setpoint, uint16_t input, Q16* output)
+    {
+        uint32_t dt_ms;
+        if (!isSampleDue(&dt_ms))
+            return false;
+
+        Q16 pv;
+        if (mode_ == Mode::gradient) {
+            Q16 rate = Q16::fromRatio((static_cast<int32_t>(input) - last_input_) * 1000, dt_ms);
+            pv = last_pv_ + (rate - last_pv_) * filter_alpha_;
+        }
+        else {
+            pv = input;
+        }
+        last_input_ = input;
+
+        *output = computeOutput(setpoint, pv, dt_ms);
+        return true;
+    }
+
+    /**
+     * Gradient mode with the rate measured elsewhere, e.g. by a state
+     * estimator, instead of from the difference between inputs. The rate is
+     * used as is, only the derivative term is filtered.
+     *
+     * @param setpoint rate (0.1°C/s)
+     * @param rate current rate (0.1°C/s)
+     * @param output receives the new output if one is computed
+     *
+     * @return true if @p output was updated
+     */
+    bool computeFromRate(Q16 setpoint, Q16 rate, Q16* output)
+    {
+        uint32_t dt_ms;
+        if (!isSampleDue(&dt_ms))
+            return false;
+        *output = computeOutput(setpoint, rate, dt_ms);
+        return true;
+    }
+
+private:
+    static constexpr uint16_t gain_scale = 10;
+
+    Q16 out_min_;
+    Q16 out_max_;
+    const GetMillisFunc get_millis_func_;
+
+    Q16 kp_;
+    Q16 ki_;
+    Q16 kd_;
+    Mode mode_ = Mode::normal;
+    uint16_t sampling_period_ms_ = 1000;
+    uint16_t filter_ms_ = 0;
+    Q16 filter_alpha_ = 1;
+    uint64_t last_time_ms_ = 0;
+    uint16_t last_input_ = 0;
+    Q16 last_pv_;
+    Q16 integral_;
+    /// Filtered derivative term
+    Q16 deriv_;
+    /// Next sample is the first since init, @p integral_ holds the output
+    bool first_sample_ = false;
+
+    bool isSampleDue(uint32_t* dt_ms)
+    {
+        uint64_t now = get_millis_func_();
+        *dt_ms = now - last_time_ms_;
+        if (*dt_ms + sample_early_ms < sampling_period_ms_)
+            return false;
+        last_time_ms_ = now;
+        return true;
+    }
+
+    Q16 computeOutput(Q16 setpoint, Q16 pv, uint32_t dt_ms)
+    {
+        Q16 dt_s = Q16::fromRatio(dt_ms, 1000);
+        Q16 err = setpoint - pv;
+
+        if (first_sample_) {
+            // No previous measurement for the derivative, and the integral
+            // takes up the difference from the output applied at init
+            first_sample_ = false;
+            last_pv_ = pv;
+            integral_ = (integral_ - kp_ * err).clamp(out_min_, out_max_);
+        }
+        else {
+            integral_ += ki_ * err * dt_s;
+        }
+        deriv_ += (kd_ * (pv - last_pv_) / dt_s - deriv_) * filter_alpha_;
+        last_pv_ = pv;
+
+        Q16 output = kp_ * err + integral_ - deriv_;
+        Q16 limited = output.clamp(out_min_, out_max_);
+        if (limited != output) {
+            Q16 tracking = kp_ > 0 ? std::min(ki_ * dt_s / kp_, Q16(1)) : Q16(1);
+            integral_ += (limited - output) * tracking;
+        }
+        integral_ = integral_.clamp(out_min_, out_max_);
+        return limited;
+    }
+};
+
+#endif /* SRC_OVEN_PID_CTRL_H_ */
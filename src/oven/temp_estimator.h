@@ -0,0 +1,88 @@
+#ifndef SRC_OVEN_TEMP_ESTIMATOR_H_
+#define SRC_OVEN_TEMP_ESTIMATOR_H_
+
+#include <cstdint>
+#include "fixed_point.h"
+
+/**
+ * Kalman filter estimating the oven temperature and its rate of change from
+ * the thermocouple samples.
+ *
+ * Constant rate model with the rate driven by white noise (the heating
+ * elements/door changing the rate). Units are 0.1°C, 0.1°C/s and seconds.
+ *
+ * The rate from the difference of consecutive samples is dominated by the
+ * 0.1°C resolution at sub-second sample intervals; the estimate is smooth
+ * enough to use directly for gradient control and display.
+ */
+class TempEstimator {
+public:
+    /// Measurement noise variance (0.1°C)^2, includes the 0.1°C resolution
+    inline static constexpr Q16 meas_var = 1;
+    /// Rate change noise spectral density (0.1°C/s)^2/s
+    inline static constexpr Q16 rate_noise = 10;
+    /// Initial rate variance (0.1°C/s)^2
+    inline static constexpr Q16 init_rate_var = 100;
+    /// Larger gaps between samples restart the filter
+    inline static constexpr uint16_t max_sample_gap_ms = 5000;
+
+    /**
+     * Add a sample. The first sample (or one after a gap) initializes the
+     * estimate with zero rate.
+     *
+     * @param temp 0.1°C
+     * @param timestamp_ms sample time
+     */
+    void addSample(int16_t temp, uint32_t timestamp_ms)
+    {
+        uint32_t dt_ms = timestamp_ms - last_time_ms_;
+        last_time_ms_ = timestamp_ms;
+        if (!valid_ || dt_ms > max_sample_gap_ms) {
+            temp_ = temp;
+            rate_ = 0;
+            p00_ = meas_var;
+            p01_ = 0;
+            p11_ = init_rate_var;
+            valid_ = true;
+            return;
+        }
+
+        // Predict
+        Q16 dt = Q16::fromRatio(dt_ms, 1000);
+        temp_ += rate_ * dt;
+        Q16 q11 = rate_noise * dt;
+        Q16 q01 = q11 * dt / 2;
+        Q16 q00 = q01 * dt * 2 / 3;
+        p00_ += dt * (p01_ * 2 + dt * p11_) + q00;
+        p01_ += dt * p11_ + q01;
+        p11_ += q11;
+
+        // Update
+        Q16 s = p00_ + meas_var;
+        Q16 k0 = p00_ / s;
+        Q16 k1 = p01_ / s;
+        Q16 innovation = Q16(temp) - temp_;
+        temp_ += k0 * innovation;
+        rate_ += k1 * innovation;
+        p11_ -= k1 * p01_;
+        p00_ -= k0 * p00_;
+        p01_ -= k0 * p01_;
+    }
+
+    /// 0.1°C
+    Q16 getTemp() const { return temp_; }
+    /// 0.1°C/s
+    Q16 getRate() const { return rate_; }
+
+private:
+    Q16 temp_;
+    Q16 rate_;
+    // Estimate covariance
+    Q16 p00_;
+    Q16 p01_;
+    Q16 p11_;
+    uint32_t last_time_ms_ = 0;
+    bool valid_ = false;
+};
+
+#endif /* SRC_OVEN_TEMP_ESTIMATOR_H_ */
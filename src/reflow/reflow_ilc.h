@@ -0,0 +1,90 @@
+#ifndef SRC_REFLOW_REFLOW_ILC_H_
+#define SRC_REFLOW_REFLOW_ILC_H_
+
+#include <cstdint>
+#include <cstring>
+#include "fixed_point.h"
+#include "reflow/reflow_profiles.h"
+
+/**
+ * Iterative learning control for repeated runs of a reflow profile.
+ *
+ * The profile up to the end of the dwell is split into equal time bins, each
+ * with a power correction stored in the profile. During a run the tracking
+ * error is averaged per bin and once the run completes each correction is
+ * updated from the average error of the following bin (the heating elements
+ * respond a bin or so later). Errors that repeat from run to run are removed
+ * over a few runs.
+ */
+class ReflowIlc {
+public:
+    /// Power correction per 0.1°C of average error
+    inline static constexpr Q16 learning_gain = Q16::fromFloat(.1);
+    /// Corrections are limited to +/- this power percentage
+    inline static constexpr int8_t max_correction = 40;
+
+    void init(ReflowProfiles::Profile& profile)
+    {
+        ReflowProfiles::Profile::TempPoint points[ReflowProfiles::Profile::num_profile_points];
+        profile.covertToPoints(points);
+        uint16_t dwell_end_s = points[ReflowProfiles::Profile::num_profile_points - 2].time_s;
+
+        profile_ = &profile;
+        bin_s_ = (dwell_end_s + num_bins - 1) / num_bins;
+        if (bin_s_ == 0)
+            bin_s_ = 1;
+        memset(error_sum_, 0, sizeof(error_sum_));
+        memset(error_count_, 0, sizeof(error_count_));
+    }
+
+    /**
+     * @param time_s elapsed profile time
+     *
+     * @return power percentage to add at @p time_s
+     */
+    int8_t getCorrection(uint16_t time_s) const
+    {
+        uint8_t bin = time_s / bin_s_;
+        return bin < num_bins ? profile_->power_correction[bin] : 0;
+    }
+
+    /**
+     * Record the tracking error. Times after the end of the dwell are ignored.
+     *
+     * @param time_s elapsed profile time
+     * @param error target minus oven temperature in 0.1°C
+     */
+    void addError(uint16_t time_s, int16_t error)
+    {
+        uint8_t bin = time_s / bin_s_;
+        if (bin >= num_bins || error_count_[bin] == UINT16_MAX)
+            return;
+        error_sum_[bin] += error;
+        error_count_[bin]++;
+    }
+
+    /// Update the profile corrections from the recorded errors. Call once
+    /// on completion of a run.
+    void update()
+    {
+        for (uint8_t bin = 0; bin + 1 < num_bins; bin++) {
+            uint16_t count = error_count_[bin + 1];
+            if (count == 0)
+                continue;
+            Q16 avg_error = Q16(error_sum_[bin + 1]) / count;
+            int16_t correction = profile_->power_correction[bin] + (avg_error * learning_gain).round();
+            profile_->power_correction[bin] = correction < -max_correction ? -max_correction
+                    : correction > max_correction ? max_correction : correction;
+        }
+    }
+
+private:
+    inline static constexpr uint8_t num_bins = ReflowProfiles::num_correction_bins;
+
+    ReflowProfiles::Profile* profile_ = nullptr;
+    uint16_t bin_s_ = 1;
+    int32_t error_sum_[num_bins];
+    uint16_t error_count_[num_bins];
+};
+
+#endif /* SRC_REFLOW_REFLOW_ILC_H_ */
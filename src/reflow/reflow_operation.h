@@ -3,6 +3,7 @@
 
 #include <cstdint>
 #include "misc_math.h"
+#include "fixed_point.h"
 #include "reflow/reflow_profiles.h"
 
 /**
@@ -17,12 +18,76 @@ public:
         dwelling_ = false;
     }
 
+    /// True once the profile peak is reached
+    bool isDwelling() const { return dwelling_; }
+
+    /// Peak profile temperature in 0.1°C
+    uint16_t getMaxTemp() const { return profile_->maxTemp(); }
+
+    /**
+     * Find the profile time at which the preheat or soak reaches @p temp, to
+     * join the profile there when the oven is already warm.
+     *
+     * @param temp current oven temperature in 0.1°C
+     * @param time_s receives the profile time in seconds
+     *
+     * @return false if @p temp is beyond the end of the soak
+     */
+    bool getWarmStartTime(uint16_t temp, uint16_t* time_s) const
+    {
+        static constexpr uint8_t soak_end_point = 2;
+
+        if (temp <= profile_temps_[0].temp) {
+            *time_s = 0;
+            return true;
+        }
+        for (uint8_t i = 1; i <= soak_end_point; i++) {
+            const ReflowProfiles::Profile::TempPoint& start = profile_temps_[i - 1];
+            const ReflowProfiles::Profile::TempPoint& end = profile_temps_[i];
+            if (temp < end.temp && temp >= start.temp) {
+                *time_s = Libp::linearInterp(start.temp, start.time_s, end.temp, end.time_s, temp);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * Return the cooling target once the dwell has finished. Cooling runs
+     * from the end of the actual dwell, which may be later than the profile
+     * time if the peak was reached late.
+     *
+     * @param time_s elapsed profile time in seconds
+     *
+     * @return target temperature in 0.1°C, @p ReflowProfiles::end_temp after
+     *         the end of the cooling segment
+     */
+    uint16_t getCoolingTargetTemp(uint16_t time_s) const
+    {
+        uint16_t cool_start_s = dwell_start_time_s + profile_->reflow_dwell_duration;
+        uint16_t cool_end_s = cool_start_s + profile_->cool_duration;
+        if (time_s <= cool_start_s)
+            return profile_->maxTemp();
+        if (time_s >= cool_end_s)
+            return ReflowProfiles::end_temp;
+        return Libp::linearInterp(cool_start_s, profile_->maxTemp(), cool_end_s, ReflowProfiles::end_temp, time_s);
+    }
 
     bool isFinished(uint16_t time_s) {
         return dwelling_ && ((time_s - dwell_start_time_s) >= profile_->reflow_dwell_duration);
     }
 
-    uint16_t getTargetSlope(uint16_t oven_temp, uint16_t time_s, uint16_t look_ahead_s)
+    /**
+     * Return the rate of change required to reach the profile temperature
+     * \p look_ahead_s seconds from now.
+     *
+     * @param oven_temp current temperature in 0.1°C
+     * @param time_s elapsed profile time in seconds
+     * @param look_ahead_s
+     *
+     * @return target slope in 0.1°C/s
+     */
+    Q16 getTargetSlope(uint16_t oven_temp, uint16_t time_s, uint16_t look_ahead_s)
     {
         static constexpr uint16_t dwell_temp_err_mgn = 30;
 
@@ -32,30 +97,24 @@ public:
         }
 
         if (dwelling_) {
-            return (profile_->maxTemp() - oven_temp) / look_ahead_s;
+            return Q16(profile_->maxTemp() - oven_temp) / look_ahead_s;
         }
         else {
             uint16_t target_temp_t_plus_look_ahead = getReflowTargetTemp(time_s + look_ahead_s);
             return target_temp_t_plus_look_ahead == 0
-                    ? 0
-                    : (target_temp_t_plus_look_ahead - oven_temp) / look_ahead_s;
+                    ? Q16(0)
+                    : Q16(target_temp_t_plus_look_ahead - oven_temp) / look_ahead_s;
         }
     }
 
-
-private:
-    uint16_t dwell_start_time_s = 0;
-    bool dwelling_ = false;
-    ReflowProfiles::Profile::TempPoint profile_temps_[ReflowProfiles::Profile::num_profile_points];
-    ReflowProfiles::Profile* profile_ = nullptr;
-
     /**
      * Return the target reflow profile temperature at a specific point in
      * profile time.
      *
      * @param time_s elapsed profile time in seconds
      *
-     * @return target temperature at time \p time_s in 0.1°C.
+     * @return target temperature at time \p time_s in 0.1°C, or 0 if
+     *         \p time_s is beyond the end of the profile.
      */
     uint16_t getReflowTargetTemp(uint16_t time_s)
     {
@@ -76,6 +135,12 @@ private:
         return 0;
     }
 
+private:
+    uint16_t dwell_start_time_s = 0;
+    bool dwelling_ = false;
+    ReflowProfiles::Profile::TempPoint profile_temps_[ReflowProfiles::Profile::num_profile_points];
+    ReflowProfiles::Profile* profile_ = nullptr;
+
 };
 
 #endif /* SRC_OVEN_REFLOW_OPERATION_H_ */
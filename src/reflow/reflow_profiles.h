@@ -3,6 +3,7 @@
 
 #include <main.h>
 #include <cstdint>
+#include <cstring>
 
 /**
  * Wrapper around array of reflow profiles to manage
@@ -19,6 +20,8 @@ public:
     inline static constexpr uint16_t end_temp = 1000;
     /// Maximum number of profiles (fixed array size)
     inline static constexpr uint8_t max_profiles_ = 10;
+    /// Number of learned power corrections kept per profile
+    inline static constexpr uint8_t num_correction_bins = 16;
 
     struct Profile {
         struct Stage {
@@ -40,6 +43,9 @@ public:
         uint16_t reflow_dwell_duration;
         /// Duration in seconds to fall to `END_TEMP`
         uint16_t cool_duration;
+        /// Power percentage corrections learned over previous runs, equally
+        /// spaced up to the end of the dwell (see @p ReflowIlc)
+        int8_t power_correction[num_correction_bins];
 
         /// Return the total reflow profile duration in seconds
         uint16_t getTotalDuration() const
@@ -47,6 +53,11 @@ public:
             return preheat.duration + soak.duration + reflow_ramp.duration
                     + reflow_dwell_duration + cool_duration;
         }
+        /// Discard the learned corrections, e.g. after the profile is edited
+        void clearCorrection()
+        {
+            memset(power_correction, 0, sizeof(power_correction));
+        }
         /// Return the final ramp temperature.
         uint16_t maxTemp() const
         {
@@ -92,7 +103,8 @@ public:
         { 90, 1700},
         { 45, 2200},
         15,
-        40 // -3deg/sec
+        40, // -3deg/sec
+        { }
     };
     inline static constexpr Profile pbfree {
         "Pb_Free",
@@ -101,7 +113,8 @@ public:
         {120, 1800},
         { 45, 2500},
         15,
-        42
+        42,
+        { }
     };
 
     /**
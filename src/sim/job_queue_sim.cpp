@@ -0,0 +1,102 @@
+/**
+ * Host (native) simulation of @p JobQueue.
+ *
+ * Runs a queue of back to back reflow and bake jobs through @p OvenOperation
+ * against the thermal model in oven_sim.h on a virtual clock. As on target,
+ * @p OvenOperation::process runs every control tick and the queue is driven
+ * from a faster UI loop, so a queue that misreads the oven state between a
+ * start and the next tick stops early. The operator acknowledges each board
+ * @p load_delay_s after the previous run completes.
+ *
+ * Outputs one CSV line per completed run:
+ *
+ *     time_s,job,runs_done,run_s,cooldown_s,load_wait_s
+ *
+ * Usage: program [reflow_runs [bake_runs [load_delay_s [controller]]]]
+ *   reflow_runs runs of Sn63_Pb37 (default 2)
+ *   bake_runs   runs of a 10 min 120°C bake (default 1)
+ *   load_delay_s (default 60)
+ *   controller  reflow control, pid (default) or ff (feed-forward)
+ */
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "oven/pid_ctrl.h"
+#include "oven/oven_sim.h"
+#include "oven/oven_hardware.h"
+#include "oven/oven_operation.h"
+#include "oven/job_queue.h"
+#include "reflow/reflow_profiles.h"
+
+static_assert(MOCK_OVEN, "Native build requires MOCK_OVEN=1");
+
+/// Must match the control tick rate in app_loop.cpp
+static constexpr uint16_t control_tick_period_ms = OvenOperation::min_control_period_ms;
+static constexpr uint16_t ui_loop_period_ms = 5;
+static constexpr uint32_t max_sim_time_ms = 4 * 60 * 60 * 1000;
+
+static uint64_t sim_time_ms_ = 0;
+static uint64_t run_complete_ms_ = 0;
+static JobQueue* job_queue_ = nullptr;
+
+static uint64_t getSimMillis() { return sim_time_ms_; }
+
+static void onRunComplete()
+{
+    uint8_t idx = job_queue_->getCurrentJob();
+    const JobQueue::Stats& stats = job_queue_->getJob(idx).stats;
+    printf("%d,%d,%d,%d,%d,%d\n", (int)(sim_time_ms_ / 1000), (int)idx, (int)stats.runs_done,
+            (int)stats.run_s, (int)stats.cooldown_s, (int)stats.load_wait_s);
+    run_complete_ms_ = sim_time_ms_;
+}
+
+int main(int argc, char* argv[])
+{
+    uint8_t reflow_runs = argc > 1 ? atoi(argv[1]) : 2;
+    uint8_t bake_runs = argc > 2 ? atoi(argv[2]) : 1;
+    uint32_t load_delay_ms = (argc > 3 ? atoi(argv[3]) : 60) * 1000;
+    OvenOperation::ReflowControl control = argc > 4 && strcmp(argv[4], "ff") == 0
+            ? OvenOperation::ReflowControl::feed_forward
+            : OvenOperation::ReflowControl::pid;
+
+    static ReflowProfiles::Profile profile_array[ReflowProfiles::max_profiles_] = {
+            ReflowProfiles::sn63pb37 };
+    ReflowProfiles profiles(profile_array);
+
+    OvenSim oven_sim(getSimMillis);
+    OvenHardware oven(oven_sim);
+    PidCtrl pid_ctrl(40, 10, 5, 0, 100, getSimMillis);
+    OvenOperation oven_operation(oven, pid_ctrl, getSimMillis);
+    JobQueue job_queue(oven_operation, profiles, getSimMillis);
+    job_queue_ = &job_queue;
+    job_queue.setRunCompleteCb(onRunComplete);
+
+    if ((reflow_runs > 0 && !job_queue.addReflow(0, control, reflow_runs))
+            || (bake_runs > 0 && !job_queue.addBake(10 * 60, 1200, bake_runs))
+            || !job_queue.start()) {
+        fprintf(stderr, "Queue did not start\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("time_s,job,runs_done,run_s,cooldown_s,load_wait_s\n");
+    while (job_queue.getState() != JobQueue::State::idle && sim_time_ms_ < max_sim_time_ms) {
+        sim_time_ms_ += ui_loop_period_ms;
+        if (sim_time_ms_ % control_tick_period_ms == 0)
+            oven_operation.process();
+        oven_operation.dispatchEvents();
+        if (job_queue.getState() == JobQueue::State::next_run && !job_queue.isLoaded()
+                && sim_time_ms_ - run_complete_ms_ >= load_delay_ms)
+            job_queue.acknowledgeLoaded();
+        job_queue.process();
+    }
+
+    uint16_t runs = 0;
+    for (uint8_t i = 0; i < job_queue.getNumJobs(); i++)
+        runs += job_queue.getJob(i).stats.runs_done;
+    if (runs != reflow_runs + bake_runs) {
+        fprintf(stderr, "Queue stopped after %d of %d runs\n", (int)runs, (int)(reflow_runs + bake_runs));
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
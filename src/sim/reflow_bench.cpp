@@ -0,0 +1,102 @@
+/**
+ * Closed loop reflow quality benchmark.
+ *
+ * Runs the built in reflow profiles through @p OvenOperation against the
+ * thermal model and outputs the tracking/quality metrics as JSON, for use as
+ * a regression baseline for control or profile changes.
+ *
+ * Temperatures are reported in °C, times in seconds and the integrated
+ * absolute error in °C·s.
+ *
+ * Usage: program [kp ki kd [controller [runs [period_ms]]]]
+ *   controller pid (default) or ff (feed-forward)
+ *   runs       consecutive runs of each profile (default 1), carrying the
+ *              learned corrections over. Metrics are for the last run.
+ *   period_ms  control period (default 1000)
+ */
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "sim/reflow_sim.h"
+#include "sim/reflow_metrics.h"
+
+struct BenchProfile {
+    const ReflowProfiles::Profile& profile;
+    /// 0.1°C
+    uint16_t liquidus_temp;
+};
+
+static const BenchProfile bench_profiles[] = {
+        { ReflowProfiles::sn63pb37, 1830 },
+        { ReflowProfiles::pbfree,   2170 },
+};
+
+/// Print 0.1 unit value as decimal
+static void printTenths(const char* key, int32_t value, bool last = false)
+{
+    printf("\"%s\": %s%d.%d%s", key,
+            value < 0 ? "-" : "", (int)(abs(value) / 10), (int)(abs(value) % 10),
+            last ? "" : ", ");
+}
+
+static bool runProfile(ReflowProfiles::Profile& profile, ReflowSim::PidGains gains,
+        OvenOperation::ReflowControl control, uint16_t period_ms, ReflowMetrics* metrics)
+{
+    return ReflowSim::run(profile, gains,
+            [](const ReflowSim::Sample& sample, void* user_data)
+            {
+                static_cast<ReflowMetrics*>(user_data)->addSample(sample);
+            }, metrics, control, period_ms);
+}
+
+int main(int argc, char* argv[])
+{
+    ReflowSim::PidGains gains = { 40, 10, 5 };
+    if (argc > 3) {
+        gains.kp = atoi(argv[1]);
+        gains.ki = atoi(argv[2]);
+        gains.kd = atoi(argv[3]);
+    }
+    bool feed_forward = argc > 4 && strcmp(argv[4], "ff") == 0;
+    OvenOperation::ReflowControl control = feed_forward
+            ? OvenOperation::ReflowControl::feed_forward
+            : OvenOperation::ReflowControl::pid;
+    int runs = argc > 5 ? atoi(argv[5]) : 1;
+    if (runs < 1)
+        runs = 1;
+    uint16_t period_ms = argc > 6 ? atoi(argv[6]) : OvenOperation::max_control_period_ms;
+
+    bool all_complete = true;
+    printf("{\"kp\": %d, \"ki\": %d, \"kd\": %d, \"controller\": \"%s\", \"runs\": %d, \"period_ms\": %d, \"profiles\": [\n",
+            (int)gains.kp, (int)gains.ki, (int)gains.kd, feed_forward ? "feed_forward" : "pid", runs, (int)period_ms);
+
+    constexpr uint8_t num_profiles = sizeof(bench_profiles) / sizeof(BenchProfile);
+    for (uint8_t i = 0; i < num_profiles; i++) {
+        ReflowProfiles::Profile profile = bench_profiles[i].profile;
+        printf("  {\"name\": \"%s\", \"iae_by_run_c_s\": [", profile.name);
+        for (int run = 1; run < runs; run++) {
+            ReflowMetrics run_metrics(profile.maxTemp(), bench_profiles[i].liquidus_temp);
+            runProfile(profile, gains, control, period_ms, &run_metrics);
+            printf("%d.%d, ", (int)(run_metrics.iae() / 10), (int)(run_metrics.iae() % 10));
+        }
+        ReflowMetrics metrics(profile.maxTemp(), bench_profiles[i].liquidus_temp);
+        bool complete = runProfile(profile, gains, control, period_ms, &metrics);
+        printf("%d.%d], ", (int)(metrics.iae() / 10), (int)(metrics.iae() % 10));
+        all_complete &= complete;
+
+        printf("\"completed\": %s, ", complete ? "true" : "false");
+        printTenths("iae_c_s", metrics.iae());
+        printTenths("max_abs_error_c", metrics.maxAbsError());
+        printTenths("peak_temp_c", metrics.peakTemp());
+        printTenths("peak_overshoot_c", metrics.peakOvershoot());
+        printf("\"time_above_liquidus_s\": %d, \"ramp_rate_violations_s\": %d, \"cycle_time_s\": %d}%s\n",
+                (int)metrics.timeAboveLiquidus(),
+                (int)metrics.rampViolations(),
+                (int)metrics.cycleTime(),
+                i == num_profiles - 1 ? "" : ",");
+    }
+    printf("]}\n");
+
+    return all_complete ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,82 @@
+#ifndef SRC_SIM_REFLOW_METRICS_H_
+#define SRC_SIM_REFLOW_METRICS_H_
+
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+#include "sim/reflow_sim.h"
+
+/**
+ * Closed loop reflow quality metrics accumulated from the once per second
+ * samples of a @p ReflowSim run.
+ *
+ * All temperatures are in 0.1°C.
+ */
+class ReflowMetrics {
+public:
+    /// J-STD-020 maximum ramp rates (0.1°C/s)
+    inline static constexpr int16_t max_ramp_up_rate = 30;
+    inline static constexpr int16_t max_ramp_down_rate = 60;
+
+    /**
+     * @param max_temp profile peak temperature
+     * @param liquidus_temp solder liquidus temperature
+     */
+    ReflowMetrics(uint16_t max_temp, uint16_t liquidus_temp)
+            : max_temp_(max_temp), liquidus_temp_(liquidus_temp)
+    { }
+
+    void addSample(const ReflowSim::Sample& sample)
+    {
+        cycle_time_s_ = sample.time_s;
+        peak_temp_ = std::max(peak_temp_, sample.temp);
+
+        if (sample.temp >= liquidus_temp_)
+            time_above_liquidus_s_++;
+
+        if (have_last_) {
+            int16_t rate = sample.temp - last_temp_;
+            if (rate > max_ramp_up_rate || rate < -max_ramp_down_rate)
+                ramp_violations_++;
+        }
+        last_temp_ = sample.temp;
+        have_last_ = true;
+
+        // Tracking error while following the profile (cooling is not
+        // actively controlled)
+        if (sample.state == OvenOperation::State::reflow_tracking && sample.target_temp != 0) {
+            int16_t err = sample.temp - sample.target_temp;
+            iae_ += abs(err);
+            max_abs_err_ = std::max<uint16_t>(max_abs_err_, abs(err));
+        }
+    }
+
+    /// Integrated absolute tracking error while following the profile
+    /// (0.1°C·s)
+    uint32_t iae() const { return iae_; }
+    /// Largest absolute deviation from the profile
+    uint16_t maxAbsError() const { return max_abs_err_; }
+    /// Peak temperature above the profile maximum (0 if never exceeded)
+    uint16_t peakOvershoot() const { return peak_temp_ > max_temp_ ? peak_temp_ - max_temp_ : 0; }
+    uint16_t peakTemp() const { return peak_temp_; }
+    uint16_t timeAboveLiquidus() const { return time_above_liquidus_s_; }
+    /// Number of seconds where the ramp rate limits were exceeded
+    uint16_t rampViolations() const { return ramp_violations_; }
+    /// Start of warming to end of cooling
+    uint16_t cycleTime() const { return cycle_time_s_; }
+
+private:
+    const uint16_t max_temp_;
+    const uint16_t liquidus_temp_;
+
+    uint32_t iae_ = 0;
+    uint16_t max_abs_err_ = 0;
+    uint16_t peak_temp_ = 0;
+    uint16_t time_above_liquidus_s_ = 0;
+    uint16_t ramp_violations_ = 0;
+    uint16_t cycle_time_s_ = 0;
+    uint16_t last_temp_ = 0;
+    bool have_last_ = false;
+};
+
+#endif /* SRC_SIM_REFLOW_METRICS_H_ */
@@ -0,0 +1,105 @@
+#ifndef SRC_SIM_REFLOW_SIM_H_
+#define SRC_SIM_REFLOW_SIM_H_
+
+#include <cstdint>
+#include "oven/pid_ctrl.h"
+#include "oven/oven_sim.h"
+#include "oven/oven_hardware.h"
+#include "oven/oven_operation.h"
+#include "reflow/reflow_operation.h"
+#include "reflow/reflow_profiles.h"
+
+static_assert(MOCK_OVEN, "Native build requires MOCK_OVEN=1");
+
+/**
+ * Runs a reflow profile through @p OvenOperation against @p OvenSim on a
+ * virtual clock.
+ */
+class ReflowSim {
+public:
+    /// Must match the control tick rate in app_loop.cpp
+    inline static constexpr uint16_t control_tick_period_ms = OvenOperation::min_control_period_ms;
+    /// Abort the simulation if the operation hasn't finished by now
+    inline static constexpr uint32_t max_sim_time_ms = 30 * 60 * 1000;
+
+    struct PidGains {
+        uint16_t kp;
+        uint16_t ki;
+        uint16_t kd;
+    };
+
+    /// State once per simulated second
+    struct Sample {
+        uint16_t time_s;
+        OvenOperation::State state;
+        /// Profile temperature (0.1°C), 0 if not tracking the profile
+        uint16_t target_temp;
+        /// Oven temperature (0.1°C)
+        uint16_t temp;
+        uint8_t power_level;
+    };
+
+    using SampleFunc = void (*)(const Sample& sample, void* user_data);
+
+    /**
+     * Run the simulation to completion.
+     *
+     * @param profile
+     * @param gains
+     * @param sample_func called once per simulated second
+     * @param user_data passed to @p sample_func
+     * @param control profile tracking method
+     * @param control_period_ms see @p OvenOperation::setControlPeriod
+     *
+     * @return true if the reflow ran to completion
+     */
+    static bool run(ReflowProfiles::Profile& profile, PidGains gains,
+            SampleFunc sample_func, void* user_data,
+            OvenOperation::ReflowControl control = OvenOperation::ReflowControl::pid,
+            uint16_t control_period_ms = OvenOperation::max_control_period_ms)
+    {
+        sim_time_ms_ = 0;
+        complete_ = false;
+
+        OvenSim oven_sim(getSimMillis);
+        OvenHardware oven(oven_sim);
+        PidCtrl pid_ctrl(gains.kp, gains.ki, gains.kd, 0, 100, getSimMillis);
+        OvenOperation oven_operation(oven, pid_ctrl, getSimMillis);
+
+        // For target temperature output only
+        ReflowOperation target;
+        target.init(profile);
+
+        if (!oven_operation.setControlPeriod(control_period_ms)
+                || !oven_operation.startReflow(profile, [] { complete_ = true; }, control))
+            return false;
+
+        while (!complete_ && sim_time_ms_ < max_sim_time_ms) {
+            sim_time_ms_ += control_tick_period_ms;
+            oven_operation.process();
+            oven_operation.dispatchEvents();
+
+            if (sim_time_ms_ % 1000 == 0) {
+                OvenOperation::Snapshot snapshot = oven_operation.getSnapshot();
+                bool tracking = snapshot.state == OvenOperation::State::reflow_tracking
+                        || snapshot.state == OvenOperation::State::reflow_cooling;
+                Sample sample = {
+                        static_cast<uint16_t>(sim_time_ms_ / 1000),
+                        snapshot.state,
+                        tracking ? target.getReflowTargetTemp(snapshot.elapsed_s) : (uint16_t)0,
+                        snapshot.temp,
+                        snapshot.power_level };
+                sample_func(sample, user_data);
+            }
+        }
+        return complete_;
+    }
+
+private:
+    inline static uint64_t sim_time_ms_ = 0;
+    inline static bool complete_ = false;
+
+    static uint64_t getSimMillis() { return sim_time_ms_; }
+};
+
+#endif /* SRC_SIM_REFLOW_SIM_H_ */
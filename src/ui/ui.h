@@ -2,22 +2,24 @@
 #define SRC_UI_UI_H_
 
 #include "oven/oven_operation.h"
-#include "pid/pid_algo.h"
+#include "oven/pid_ctrl.h"
+#include "oven/job_queue.h"
 #include "ui/ui_common.h"
 
 inline
-void buildUi(OvenOperation* oven_operation, Libp::PidAlgo* pid_algo)
+void buildUi(OvenOperation* oven_operation, PidCtrl* pid_ctrl, JobQueue* job_queue)
 {
     statusHeaderInit();
     pageMainmenuInit();
-    pageReflowInit(oven_operation);
+    pageReflowInit(oven_operation, job_queue);
     pageRefloweditInit();
     pageReflowrunInit();
-    pageBakeInit(oven_operation);
+    pageBakeInit(oven_operation, job_queue);
     pageBakerunInit();
-    pageSetupInit(pid_algo);
+    pageSetupInit(pid_ctrl, oven_operation);
     pageAboutInit();
-    pageManualOvenOp(oven_operation);
+    pageManualOvenOp(oven_operation, pid_ctrl);
+    pageJobQueueInit(job_queue);
     showPage(Pages::main_menu);
 }
 
@@ -93,6 +93,7 @@ namespace MenuLabel {
     inline constexpr const char* setup     = "Setup";
     inline constexpr const char* about     = "About";
     inline constexpr const char* manual    = "Advanced";
+    inline constexpr const char* queue     = "Queue";
 }
 
 enum class Pages : uint8_t {
@@ -107,6 +108,7 @@ enum class Pages : uint8_t {
     setup,
     about,
     advanced,
+    job_queue,
     LEN
 };
 
@@ -5,10 +5,10 @@
 #ifndef UI_PAGES_H_
 #define UI_PAGES_H_
 
-#include <pid/pid_algo.h>
+#include "oven/pid_ctrl.h"
 #include <cstdint>
 #include "oven/oven_operation.h"
-//#include "pid/pid_ctrl.h"
+#include "oven/job_queue.h"
 #include "lvgl/lvgl.h"
 #include "ui/ui_defs.h"
 
@@ -45,20 +45,21 @@ void pageMainmenuInit();
 
 void pageAboutInit();
 
-//void pageSetupInit(PidCtrl<float>* pid);
-void pageSetupInit(Libp::PidAlgo* pid);
+void pageSetupInit(PidCtrl* pid, OvenOperation* oven_operation);
 
-void pageBakeInit(OvenOperation* oven_operation);
+void pageBakeInit(OvenOperation* oven_operation, JobQueue* job_queue);
 
 void pageBakerunInit();
 
-void pageReflowInit(OvenOperation* oven_operation);
+void pageReflowInit(OvenOperation* oven_operation, JobQueue* job_queue);
 
 void pageRefloweditInit();
 
 void pageReflowrunInit();
 
-void pageManualOvenOp(OvenOperation* oven_operation);
+void pageManualOvenOp(OvenOperation* oven_operation, PidCtrl* pid);
+
+void pageJobQueueInit(JobQueue* job_queue);
 
 /* ========================
  * Individual Page Updates
@@ -77,11 +78,19 @@ void pageReflowrunRefresh();
 /// ????Update time and progress????
 void pageBakeRefresh();
 
+void pageJobQueueRefresh();
+
 // Refresh UI for running operations
 
 void pageBakerunRefreshUi(uint16_t elapsed_time_sec);
 
-void pageReflowrunRefreshUi(uint16_t elapsed_time_s, uint16_t oven_temp, bool cooling);
+void pageReflowrunRefreshUi(uint16_t elapsed_time_s, uint16_t start_offset_s, uint16_t oven_temp,
+        int16_t temp_rate, bool cooling);
+
+void pageManualOvenOpRefreshUi(OvenCharacterizer::Phase phase);
+
+/// Update the queue status/statistics if the queue has changed
+void pageJobQueueRefreshUi();
 
 /**
  *
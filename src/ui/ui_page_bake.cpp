@@ -4,6 +4,7 @@
 #include <cinttypes>
 #include "ui/ui_common.h"
 #include "oven/oven_operation.h"
+#include "oven/job_queue.h"
 #include "error_handler.h"
 #include "app_settings.h"
 #include "devices/speaker.h"
@@ -13,6 +14,7 @@ static constexpr uint16_t default_temp_c = 500;
 static constexpr uint16_t default_temp_f = 1200;
 
 static OvenOperation* oven_operation_;
+static JobQueue* job_queue_;
 static AppSettings& app_settings_ = AppSettings::get();
 static AppSettings::Data& settings_ = app_settings_.settings();
 
@@ -68,9 +70,10 @@ void pageBakeRefresh()
 
 static constexpr uint16_t min_bake_duration_mins = 1;
 
-void pageBakeInit(OvenOperation* oven_operation)
+void pageBakeInit(OvenOperation* oven_operation, JobQueue* job_queue)
 {
     oven_operation_ = oven_operation;
+    job_queue_ = job_queue;
     lv_obj_t* page = createPage(Pages::bake);
 
     // Create labels and inputs
@@ -125,6 +128,24 @@ void pageBakeInit(OvenOperation* oven_operation)
             nullptr);
         }
     });
+
+    // Add to job queue button
+
+    lv_obj_t* btn_queue = createDefaultBtn(page, "Queue");
+    lv_obj_align(btn_queue, btn_start, LV_ALIGN_OUT_LEFT_MID, -Padding::inner, 0);
+
+    lv_obj_set_event_cb(btn_queue, [] (struct _lv_obj_t * obj, lv_event_t event)
+    {
+        if (event == LV_EVENT_CLICKED) {
+            bool added = job_queue_->addBake(
+                    getTimeInput() * 60,
+                    settings_.convertUnits(getTempInput() * 10, settings_.units, TempUnit::celsius), 1);
+            if (added)
+                showPage(Pages::job_queue);
+            else
+                createModalMbox("Queue is full or running.", ModalMboxType::okay, nullptr, nullptr);
+        }
+    });
 }
 
 void cancelBake()
@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include "ui/ui_common.h"
 #include "ui/ui_shared_content.h"
+#include "ui/ui_view_model.h"
 
 static lv_obj_t* progress_;
 static lv_obj_t* lbl_pct_complete_;
@@ -9,6 +10,8 @@ static lv_obj_t* label_remaining_;
 static lv_obj_t* title_label_;
 // TODO; change to secs and don't calc in refreshUI
 static uint16_t bake_time_mins_ = 0;
+/// Everything on the page below the title follows from the elapsed time
+static ViewValue<uint16_t> shown_elapsed_;
 
 /// bake_temp in pref units
 static void updateTitleText(uint16_t bake_time_s, uint16_t bake_temp)
@@ -22,12 +25,16 @@ static void updateTitleText(uint16_t bake_time_s, uint16_t bake_temp)
 void pageBakerunSetBakeParams(uint16_t time_mins, uint16_t temp)
 {
     bake_time_mins_ = time_mins;
+    shown_elapsed_.invalidate();
     lv_bar_set_range(progress_, 0, time_mins * 60);
     updateTitleText(time_mins, temp);
 }
 
 void pageBakerunRefreshUi(uint16_t elapsed_time_sec)
 {
+    if (!shown_elapsed_.changed(elapsed_time_sec))
+        return;
+
     // Max time is <1000 mins so uint16_t is safe
     uint16_t total_time_secs = bake_time_mins_ * 60;
 
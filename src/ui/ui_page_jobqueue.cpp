@@ -0,0 +1,143 @@
+#include <cstdio>
+#include "ui/ui_common.h"
+#include "app_settings.h"
+#include "devices/speaker.h"
+#include "oven/job_queue.h"
+#include "lvgl/lvgl.h"
+
+static JobQueue* job_queue_;
+
+static lv_obj_t* status_label_;
+static lv_obj_t* jobs_label_;
+static lv_obj_t* btns_;
+
+/// Change count of the queue as last displayed
+static uint16_t shown_change_count_;
+
+enum BtnId : uint8_t { start = 0, loaded, stop, clear };
+
+static const char* getStatusText()
+{
+    switch (job_queue_->getState()) {
+    case JobQueue::State::running:
+        return "Running...";
+    case JobQueue::State::next_run:
+        return job_queue_->isLoaded() ? "Board loaded, cooling..." : "Load the next board and press Loaded";
+    case JobQueue::State::idle:
+    default:
+        return job_queue_->getNumJobs() == 0 ? "Add jobs from the Reflow/Bake pages" : "Ready";
+    }
+}
+
+/// One line per job: name, progress and time totals (mm:ss)
+static void updateJobsText()
+{
+    static constexpr uint8_t max_line_len = sizeof("> 1. 123456789012345 2/99  run 999:59 cool 999:59 wait 999:59\n");
+    char text[JobQueue::max_jobs * max_line_len + 1];
+    uint16_t len = 0;
+    text[0] = '\0';
+
+    const ReflowProfiles& profiles = getReflowProfiles();
+    for (uint8_t i = 0; i < job_queue_->getNumJobs(); i++) {
+        const JobQueue::Job& job = job_queue_->getJob(i);
+        const char* name = job.type == JobQueue::Job::Type::reflow
+                ? profiles.getProfile(job.profile_idx).name
+                : "Bake";
+        bool current = job_queue_->getState() != JobQueue::State::idle && job_queue_->getCurrentJob() == i;
+        len += snprintf(&text[len], sizeof(text) - len,
+                "%s%d. %s %d/%d  run %d:%02d cool %d:%02d wait %d:%02d\n",
+                current ? "> " : "", i + 1, name, job.stats.runs_done, job.count,
+                (int)(job.stats.run_s / 60), (int)(job.stats.run_s % 60),
+                (int)(job.stats.cooldown_s / 60), (int)(job.stats.cooldown_s % 60),
+                (int)(job.stats.load_wait_s / 60), (int)(job.stats.load_wait_s % 60));
+        if (len >= sizeof(text))
+            break;
+    }
+    lv_label_set_text(jobs_label_, text);
+}
+
+void pageJobQueueRefreshUi()
+{
+    if (job_queue_->getChangeCount() == shown_change_count_)
+        return;
+    shown_change_count_ = job_queue_->getChangeCount();
+
+    lv_label_set_static_text(status_label_, getStatusText());
+    updateJobsText();
+
+    bool idle = job_queue_->getState() == JobQueue::State::idle;
+    lv_btnm_set_btn_ctrl(btns_, BtnId::start, LV_BTNM_CTRL_INACTIVE, !idle || job_queue_->getNumJobs() == 0);
+    lv_btnm_set_btn_ctrl(btns_, BtnId::loaded, LV_BTNM_CTRL_INACTIVE,
+            job_queue_->getState() != JobQueue::State::next_run || job_queue_->isLoaded());
+    lv_btnm_set_btn_ctrl(btns_, BtnId::stop, LV_BTNM_CTRL_INACTIVE, idle);
+    lv_btnm_set_btn_ctrl(btns_, BtnId::clear, LV_BTNM_CTRL_INACTIVE, !idle);
+}
+
+void pageJobQueueRefresh()
+{
+    // Force an update
+    shown_change_count_ = job_queue_->getChangeCount() - 1;
+    pageJobQueueRefreshUi();
+}
+
+static void finishRun()
+{
+    // Keep the corrections learned from reflow runs
+    AppSettings::get().writeToFlash();
+    playSound(Sound::completed);
+}
+
+static void btnClickAction(lv_obj_t* btnm, lv_event_t event)
+{
+    if (event != LV_EVENT_CLICKED)
+        return;
+    uint16_t active_btn_id = lv_btnm_get_active_btn(btnm);
+    if (lv_btnm_get_btn_ctrl(btnm, active_btn_id, LV_BTNM_CTRL_INACTIVE))
+        return;
+
+    switch (active_btn_id) {
+    case BtnId::start:
+        createModalMbox("Start the queue?\nFirst board must be loaded.", ModalMboxType::yes_no, []() {
+            if (!job_queue_->start())
+                createModalMbox("Failed to start.", ModalMboxType::okay, nullptr, nullptr);
+            pageJobQueueRefreshUi();
+        }, nullptr);
+        break;
+    case BtnId::loaded:
+        job_queue_->acknowledgeLoaded();
+        pageJobQueueRefresh();
+        break;
+    case BtnId::stop:
+        createModalMbox("Stop the queue?", ModalMboxType::yes_no, []() {
+            job_queue_->stop();
+            pageJobQueueRefreshUi();
+        }, nullptr);
+        break;
+    case BtnId::clear:
+        job_queue_->clear();
+        pageJobQueueRefreshUi();
+        break;
+    }
+}
+
+void pageJobQueueInit(JobQueue* job_queue)
+{
+    job_queue_ = job_queue;
+    job_queue_->setRunCompleteCb(finishRun);
+    lv_obj_t* page = createPage(Pages::job_queue);
+
+    status_label_ = createDefaultStaticLabel(page, "", Padding::outer, Padding::outer);
+
+    jobs_label_ = lv_label_create(page, NULL);
+    lv_label_set_long_mode(jobs_label_, LV_LABEL_LONG_CROP);
+    lv_obj_set_width(jobs_label_, lv_obj_get_width(page) - Padding::outer - Padding::outer);
+    lv_obj_align(jobs_label_, status_label_, LV_ALIGN_OUT_BOTTOM_LEFT, 0, Padding::inner);
+
+    static const char* btn_lbls[] = { "Start", "Loaded", "Stop", "Clear", "" };
+    btns_ = createDefaultBtnm(page, btn_lbls);
+    lv_obj_set_size(btns_, lv_obj_get_width(page), LV_DPI / 2 + Padding::outer + Padding::outer);
+    lv_obj_align(btns_, NULL, LV_ALIGN_IN_BOTTOM_MID, 0, 0);
+    lv_obj_set_event_cb(btns_, btnClickAction);
+
+    pageJobQueueRefresh();
+}
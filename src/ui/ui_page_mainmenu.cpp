@@ -28,6 +28,9 @@ static void menuBtnClickHandler(lv_obj_t * btnm, lv_event_t event)
     case 4:
         showPage(Pages::advanced);
         break;
+    case 5:
+        showPage(Pages::job_queue);
+        break;
 /*    case 4:
         createModalMbox("Shutdown?", ModalMboxType::yes_no, shutdown, nullptr);
         break;*/
@@ -42,7 +45,8 @@ void pageMainmenuInit()
         MenuLabel::bake, "\n",  // 1
         MenuLabel::setup,       // 2
         MenuLabel::about, "\n", // 3
-        MenuLabel::manual,    // 4
+        MenuLabel::manual,      // 4
+        MenuLabel::queue,       // 5
         ""
     };
     lv_obj_t* btnm_menu = createDefaultBtnm(page, btnm_map);
@@ -2,20 +2,31 @@
 #include "lvgl/lvgl.h"
 #include "ui/ui_common.h"
 #include "oven/oven_operation.h"
+#include "oven/pid_ctrl.h"
+#include "app_settings.h"
+#include "devices/speaker.h"
+#include "ui/ui_modal.h"
 
 static lv_obj_t* power_slider_;
 static lv_obj_t* cb_off_;
 static lv_obj_t* cb_power_;
 static lv_obj_t* cb_temp_;
+static lv_obj_t* cb_tune_;
+static lv_obj_t* cb_model_;
+static lv_obj_t* btn_start_;
 static lv_obj_t* value_cont;
 
 static OvenOperation* oven_operation_;
+static PidCtrl* pid_;
 static lv_obj_t* lbl_level;
 
+static constexpr uint16_t default_autotune_temp_c = 150;
+
 enum class ManualState : uint8_t {
-    off, fixed_power, fixed_temp
+    off, fixed_power, fixed_temp, autotune, characterize
 };
 static ManualState manual_state_ = ManualState::off;
+static OvenCharacterizer::Phase shown_phase_ = OvenCharacterizer::Phase::finished;
 
 static void setState(ManualState state)
 {
@@ -28,11 +39,14 @@ static void setState(ManualState state)
         oven_operation_->stop();
         lv_obj_set_hidden(power_slider_, true);
         lv_obj_set_hidden(value_cont, true);
+        lv_obj_set_hidden(btn_start_, true);
         manual_state_ = ManualState::off;
         break;
 
     case ManualState::fixed_power:
         if (manual_state_ != ManualState::fixed_power) {
+            oven_operation_->stop();
+            lv_obj_set_hidden(btn_start_, true);
             lv_slider_set_range(power_slider_, 0, 100);
             lv_slider_set_value(power_slider_, 0, false);
             lv_obj_set_hidden(power_slider_, false);
@@ -48,6 +62,8 @@ static void setState(ManualState state)
 
     case ManualState::fixed_temp:
         if (manual_state_ != ManualState::fixed_temp) {
+            oven_operation_->stop();
+            lv_obj_set_hidden(btn_start_, true);
             lv_slider_set_range(power_slider_, 0, 250);
             lv_slider_set_value(power_slider_, 0, false);
             lv_obj_set_hidden(power_slider_, false);
@@ -60,23 +76,163 @@ static void setState(ManualState state)
         lv_label_set_static_text(lbl_level, label_text);
         lv_obj_align(lbl_level, value_cont, LV_ALIGN_CENTER, 0, 0);
         break;
+
+    case ManualState::autotune:
+        // Experiment is started by btn_start_, slider only selects the temp
+        if (manual_state_ != ManualState::autotune) {
+            oven_operation_->stop();
+            lv_slider_set_range(power_slider_,
+                    OvenOperation::min_autotune_temp / 10, OvenOperation::max_autotune_temp / 10);
+            lv_slider_set_value(power_slider_, default_autotune_temp_c, false);
+            lv_obj_set_hidden(power_slider_, false);
+            lv_obj_set_hidden(value_cont, false);
+            lv_obj_set_hidden(btn_start_, false);
+            manual_state_ = ManualState::autotune;
+            val = default_autotune_temp_c;
+        }
+        else if (oven_operation_->getState() == OvenOperation::State::autotune) {
+            // Setpoint can't be changed mid-experiment
+            return;
+        }
+        snprintf(label_text, label_max_len, "%d°C", (int)val);
+        lv_label_set_static_text(lbl_level, label_text);
+        lv_obj_align(lbl_level, value_cont, LV_ALIGN_CENTER, 0, 0);
+        break;
+
+    case ManualState::characterize:
+        // Run has no setpoint, the label shows the current step
+        if (manual_state_ != ManualState::characterize) {
+            oven_operation_->stop();
+            lv_obj_set_hidden(power_slider_, true);
+            lv_obj_set_hidden(value_cont, false);
+            lv_obj_set_hidden(btn_start_, false);
+            manual_state_ = ManualState::characterize;
+            lv_label_set_static_text(lbl_level, "Ready");
+            lv_obj_align(lbl_level, value_cont, LV_ALIGN_CENTER, 0, 0);
+        }
+        break;
     }
 }
 
-void pageManualOvenOp(OvenOperation* oven_operation)
+void pageManualOvenOpRefreshUi(OvenCharacterizer::Phase phase)
+{
+    static constexpr const char* phase_text[] {
+        // DO NOT REORDER - order must match OvenCharacterizer::Phase
+        "Heating", "Cooling", "Part heat", "Door open", "Fitting"
+    };
+
+    if (lv_obj_get_hidden(btn_start_) && phase != shown_phase_) {
+        lv_label_set_static_text(lbl_level, phase_text[static_cast<uint8_t>(phase)]);
+        lv_obj_align(lbl_level, value_cont, LV_ALIGN_CENTER, 0, 0);
+        shown_phase_ = phase;
+    }
+}
+
+static void finishAutotune()
+{
+    static constexpr uint8_t msg_max_len = sizeof("Autotune complete.\nKu=99999.99 Pu=9999.9s\nP=99999 I=99999 D=99999");
+    char msg[msg_max_len];
+
+    lv_obj_set_hidden(power_slider_, false);
+    lv_obj_set_hidden(btn_start_, false);
+
+    PidAutotune::Result result;
+    if (!oven_operation_->getAutotuneResult(&result)) {
+        playSound(Sound::error);
+        createModalMbox("Autotune failed.\nNo stable oscillation.", ModalMboxType::okay, nullptr, nullptr);
+        return;
+    }
+
+    AppSettings::Data& settings = AppSettings::get().settings();
+    settings.pid_params.kp = result.kp;
+    settings.pid_params.ki = result.ki;
+    settings.pid_params.kd = result.kd;
+    pid_->setPidParams(result.kp, result.ki, result.kd);
+
+    // Ku/Pu to two/one decimal places
+    int32_t ku = (result.ku * 100).round();
+    int32_t pu = (result.pu_s * 10).round();
+    snprintf(msg, msg_max_len, "Autotune complete.\nKu=%d.%02d Pu=%d.%ds\nP=%d I=%d D=%d",
+            (int)(ku / 100), (int)(ku % 100), (int)(pu / 10), (int)(pu % 10),
+            (int)result.kp, (int)result.ki, (int)result.kd);
+
+    if (!AppSettings::get().writeToFlash()) {
+        createModalMbox("Failed to persist settings.", ModalMboxType::okay, nullptr, nullptr);
+    }
+    else {
+        createModalMbox(msg, ModalMboxType::okay, nullptr, nullptr);
+    }
+    // After modal create to avoid being cutoff by alert sound
+    playSound(Sound::completed);
+}
+
+static void finishCharacterization()
+{
+    lv_obj_set_hidden(btn_start_, false);
+    lv_label_set_static_text(lbl_level, "Ready");
+    lv_obj_align(lbl_level, value_cont, LV_ALIGN_CENTER, 0, 0);
+
+    OvenModel model;
+    if (!oven_operation_->getCharacterizationResult(&model)) {
+        playSound(Sound::error);
+        createModalMbox("Characterization failed.\nStart from room temp.\nwith the door closed.", ModalMboxType::okay, nullptr, nullptr);
+        return;
+    }
+
+    AppSettings::get().settings().oven_model = model;
+    if (!AppSettings::get().writeToFlash()) {
+        createModalMbox("Failed to persist settings.", ModalMboxType::okay, nullptr, nullptr);
+    }
+    else {
+        createModalMbox("Characterization complete.\nOven model saved.", ModalMboxType::okay, nullptr, nullptr);
+    }
+    // After modal create to avoid being cutoff by alert sound
+    playSound(Sound::completed);
+}
+
+static void startAutotune()
+{
+    uint16_t temp = lv_slider_get_value(power_slider_) * 10;
+    if (oven_operation_->startAutotune(temp, finishAutotune)) {
+        lv_obj_set_hidden(power_slider_, true);
+        lv_obj_set_hidden(btn_start_, true);
+    }
+    else {
+        createModalMbox("Failed to start.\nOven too hot?", ModalMboxType::okay, nullptr, nullptr);
+    }
+}
+
+static void startCharacterization()
+{
+    if (oven_operation_->startCharacterization(finishCharacterization)) {
+        lv_obj_set_hidden(btn_start_, true);
+        shown_phase_ = OvenCharacterizer::Phase::finished;
+        pageManualOvenOpRefreshUi(oven_operation_->getCharacterizationPhase());
+    }
+    else {
+        createModalMbox("Failed to start.\nOven too hot?", ModalMboxType::okay, nullptr, nullptr);
+    }
+}
+
+void pageManualOvenOp(OvenOperation* oven_operation, PidCtrl* pid)
 {
     oven_operation_ = oven_operation;
+    pid_ = pid;
     lv_obj_t* page = createPage(Pages::advanced);
 
     cb_off_ = createDefaultRadioBtn(page, "Off", true);
     cb_power_ =  createDefaultRadioBtn(page, "Fixed power", false);
     cb_temp_ = createDefaultRadioBtn(page, "Fixed temp.", false);
+    cb_tune_ = createDefaultRadioBtn(page, "PID autotune", false);
+    cb_model_ = createDefaultRadioBtn(page, "Oven model", false);
 
     auto cb_action = [](_lv_obj_t * cb, lv_event_t event)
     {
         lv_cb_set_checked(cb_off_, cb == cb_off_);
         lv_cb_set_checked(cb_power_, cb == cb_power_);
         lv_cb_set_checked(cb_temp_, cb == cb_temp_);
+        lv_cb_set_checked(cb_tune_, cb == cb_tune_);
+        lv_cb_set_checked(cb_model_, cb == cb_model_);
 
         if (event != LV_EVENT_CLICKED)
         return;
@@ -89,11 +245,35 @@ void pageManualOvenOp(OvenOperation* oven_operation)
         else if (cb == cb_temp_) {
             setState(ManualState::fixed_temp);
         }
+        else if (cb == cb_tune_) {
+            setState(ManualState::autotune);
+        }
+        else if (cb == cb_model_) {
+            setState(ManualState::characterize);
+        }
     };
 
     lv_obj_set_event_cb(cb_off_, cb_action);
     lv_obj_set_event_cb(cb_power_, cb_action);
     lv_obj_set_event_cb(cb_temp_, cb_action);
+    lv_obj_set_event_cb(cb_tune_, cb_action);
+    lv_obj_set_event_cb(cb_model_, cb_action);
+
+    btn_start_ = createDefaultBtn(page, "Start "  LV_SYMBOL_RIGHT LV_SYMBOL_RIGHT);
+    lv_obj_set_event_cb(btn_start_,
+            [] (struct _lv_obj_t * obj, lv_event_t event)
+            {
+                if (event != LV_EVENT_CLICKED)
+                    return;
+                if (manual_state_ == ManualState::autotune) {
+                    createModalMbox("Run PID autotune?\nSaved PID vars. will\nbe replaced.",
+                            ModalMboxType::yes_no, startAutotune, nullptr);
+                }
+                else {
+                    createModalMbox("Characterize oven?\nTakes ~20 mins from\nroom temp. Door opens.",
+                            ModalMboxType::yes_no, startCharacterization, nullptr);
+                }
+            });
 
     power_slider_ = lv_slider_create(page, NULL);
     lv_slider_set_style(power_slider_, LV_SLIDER_STYLE_BG, &style_droplist_body);
@@ -117,9 +297,12 @@ void pageManualOvenOp(OvenOperation* oven_operation)
     lv_obj_set_pos(cb_off_, Padding::outer, Padding::outer);
     lv_obj_align(cb_power_, cb_off_, LV_ALIGN_OUT_BOTTOM_LEFT, 0, 0);
     lv_obj_align(cb_temp_, cb_power_, LV_ALIGN_OUT_BOTTOM_LEFT, 0, 0);
-    lv_obj_align(power_slider_, cb_temp_, LV_ALIGN_OUT_BOTTOM_LEFT, 0, Padding::inner);
+    lv_obj_align(cb_tune_, cb_temp_, LV_ALIGN_OUT_BOTTOM_LEFT, 0, 0);
+    lv_obj_align(cb_model_, cb_tune_, LV_ALIGN_OUT_BOTTOM_LEFT, 0, 0);
+    lv_obj_align(power_slider_, cb_model_, LV_ALIGN_OUT_BOTTOM_LEFT, 0, Padding::inner);
+    lv_obj_align(btn_start_, power_slider_, LV_ALIGN_OUT_BOTTOM_RIGHT, 0, Padding::inner);
 
-    uint16_t x_left = lv_obj_get_x(cb_temp_) + lv_obj_get_width(cb_temp_);
+    uint16_t x_left = lv_obj_get_x(cb_tune_) + lv_obj_get_width(cb_tune_);
 
     lv_obj_align(value_cont, cb_power_, LV_ALIGN_OUT_RIGHT_MID, Padding::inner*2, 0);
     lv_obj_set_x(value_cont, x_left + (lv_obj_get_width(page) - x_left + Padding::outer)/2 - lv_obj_get_width(lbl_level)/2);
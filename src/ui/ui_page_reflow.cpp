@@ -8,10 +8,12 @@
 
 static ReflowProfiles& profiles_ = getReflowProfiles();
 static OvenOperation* oven_operation_;
+static JobQueue* job_queue_;
 
 static lv_obj_t* profile_dl_;
 static lv_obj_t* profile_btns_;
 static lv_obj_t* btn_start_;
+static lv_obj_t* cb_model_ctrl_;
 
 static void updateProfileListAndBtns()
 {
@@ -52,6 +54,8 @@ static void onChangeProfile(uint8_t profile_idx)
 
 static void finishReflow()
 {
+    // Keep the corrections learned from this run
+    AppSettings::get().writeToFlash();
     playSound(Sound::completed);
     createModalMbox("Reflow operation complete.", ModalMboxType::okay, []() {
         showPage(Pages::reflow);
@@ -59,6 +63,24 @@ static void finishReflow()
 }
 
 
+static OvenOperation::ReflowControl getReflowControl()
+{
+    return lv_cb_is_checked(cb_model_ctrl_)
+            ? OvenOperation::ReflowControl::feed_forward
+            : OvenOperation::ReflowControl::pid;
+}
+
+
+static bool startReflow(bool warm_start)
+{
+    bool started = oven_operation_->startReflow(profiles_.getActiveProfile(), finishReflow,
+            getReflowControl(), warm_start);
+    if (started)
+        showPage(Pages::reflow_run);
+    return started;
+}
+
+
 static void addEditDelClickAction(lv_obj_t * btnm, lv_event_t event)
 {
     if (event != LV_EVENT_CLICKED)
@@ -88,12 +110,23 @@ static void addEditDelClickAction(lv_obj_t * btnm, lv_event_t event)
         snprintf(title, max_len, "Delete %s?", profiles_.getActiveProfile().name);
         createModalMbox(title, ModalMboxType::yes_no, []() {
             uint16_t sel_idx = lv_ddlist_get_selected(profile_dl_);
+            // Queued jobs refer to profiles by index
+            if (!job_queue_->removeProfile(sel_idx)) {
+                createModalMbox("Can't delete while the queue is running.", ModalMboxType::okay, nullptr, nullptr);
+                return;
+            }
             profiles_.deleteProfile(sel_idx);
             updateProfileListAndBtns();
             sel_idx = lv_ddlist_get_selected(profile_dl_);
             profiles_.setActiveProfile(sel_idx);
         }, nullptr);
         break;
+    case 3: // queue
+        if (job_queue_->addReflow(lv_ddlist_get_selected(profile_dl_), getReflowControl(), 1))
+            showPage(Pages::job_queue);
+        else
+            createModalMbox("Queue is full or running.", ModalMboxType::okay, nullptr, nullptr);
+        break;
     }
     // TODO: copying button ID in btnm is not necessary since this is const in lv_event_get_data()
 }
@@ -106,9 +139,10 @@ void pageReflowRefresh()
 
 // TODO: break this function up
 
-void pageReflowInit(OvenOperation* oven_operation)
+void pageReflowInit(OvenOperation* oven_operation, JobQueue* job_queue)
 {
     oven_operation_ = oven_operation;
+    job_queue_ = job_queue;
     lv_obj_t* page = createPage(Pages::reflow);
 
     // Drop list
@@ -134,25 +168,29 @@ void pageReflowInit(OvenOperation* oven_operation)
                     char buf[max_len];
                     snprintf(buf, max_len, "Run reflow profile '%s'?", profiles_.getActiveProfile().name);
                     createModalMbox(buf, ModalMboxType::yes_no, []() {
-                        bool started = oven_operation_->startReflow(profiles_.getActiveProfile(), finishReflow);
-                        if (started) {
-                            showPage(Pages::reflow_run);
-                        }
-                        else {
-                            createModalMbox("Failed to start.\nOven too hot?", ModalMboxType::okay, nullptr, nullptr);
-                        }
+                        if (startReflow(false))
+                            return;
+                        createModalMbox("Oven is above the start temperature.\nJoin the profile at the current temperature?",
+                                ModalMboxType::yes_no, []() {
+                            if (!startReflow(true))
+                                createModalMbox("Failed to start.\nOven too hot?", ModalMboxType::okay, nullptr, nullptr);
+                        }, nullptr);
                     }, nullptr);
                 }
             });
 
     lv_obj_align(btn_start_, NULL, LV_ALIGN_IN_BOTTOM_RIGHT, -Padding::outer, -Padding::outer);
 
+    // Follow the profile with the oven model, PID only corrects the error
+    cb_model_ctrl_ = createDefaultCb(page, "Model control", false);
+    lv_obj_align(cb_model_ctrl_, btn_start_, LV_ALIGN_OUT_TOP_RIGHT, 0, -Padding::narrow);
+
     // Profile create/edit buttons
 
     lv_coord_t dl_width = LV_HOR_RES_MAX - lv_obj_get_width(btn_start_) - Padding::inner - Padding::outer - Padding::outer;
 
 
-    static const char* profile_btn_lbls[] = { "New", "Edit", "Delete", "" };
+    static const char* profile_btn_lbls[] = { "New", "Edit", "Delete", "Queue", "" };
     profile_btns_  = createDefaultBtnm(page, profile_btn_lbls);
 
     // Alignment and sizing
@@ -58,6 +58,9 @@ static void readWriteFields(ReflowProfiles::Profile& prof, DataDir direction)
         lv_label_set_static_text(profile_name_label_, prof.name);
     }
     else {
+        ReflowProfiles::Profile::TempPoint old_points[ReflowProfiles::Profile::num_profile_points];
+        prof.covertToPoints(old_points);
+
         prof.preheat.duration       = intEditFieldGetValue(edit_ctrls_[FieldId::preheat_time]);
         prof.preheat.duration       = intEditFieldGetValue(edit_ctrls_[FieldId::preheat_time]);
         prof.reflow_ramp.duration   = intEditFieldGetValue(edit_ctrls_[FieldId::reflow_ramp_time]);
@@ -69,6 +72,12 @@ static void readWriteFields(ReflowProfiles::Profile& prof, DataDir direction)
         prof.reflow_ramp.final_temp = intEditFieldGetValue(edit_ctrls_[FieldId::reflow_ramp_temp]);
         prof.units = getSettings().units;
         Libp::strcpy_safe(prof.name, lv_label_get_text(profile_name_label_), ReflowProfiles::max_name_len + 1);
+
+        // Corrections learned for the old shape no longer apply
+        ReflowProfiles::Profile::TempPoint new_points[ReflowProfiles::Profile::num_profile_points];
+        prof.covertToPoints(new_points);
+        if (memcmp(old_points, new_points, sizeof(old_points)) != 0)
+            prof.clearCorrection();
     }
 }
 
@@ -1,6 +1,10 @@
+#include <cstdio>
+#include <cstdlib>
 #include "app_settings.h"
+#include "fixed_point.h"
 #include "ui/ui_common.h"
 #include "ui/ui_shared_content.h"
+#include "ui/ui_view_model.h"
 
 static const ReflowProfiles& profiles = AppSettings::get().profiles();
 
@@ -21,19 +25,77 @@ static lv_anim_t status_blink_anim_;
 
 static lv_obj_t* chart_;
 static lv_obj_t* profile_line_;
-static lv_obj_t* actual_line_;
 
 static uint16_t profile_duration_s_;
 
 static uint16_t sample_idx_;
-static float next_sample_time_s_;
+static Q16 next_sample_time_s_;
 
-static float secs_per_sample_;
-static float x_pixels_per_sec_;
-static float y_pixels_per_degree_;
+static Q16 secs_per_sample_;
+static Q16 x_pixels_per_sec_;
+static Q16 y_pixels_per_degree_;
 
 static constexpr uint16_t num_samples_ = 150;
-static lv_point_t sample_points_[num_samples_];
+
+// The trace of the actual temperature is split into short lines, each only
+// as large as its own points. Adding a sample then redraws the area of the
+// newest line only, instead of the whole trace growing with the run.
+static constexpr uint8_t points_per_line = 16;
+static constexpr uint8_t num_trace_lines = (num_samples_ - 2) / (points_per_line - 1) + 1;
+// Each line after the first starts at the last point of the previous one
+static_assert(points_per_line + (num_trace_lines - 1) * (points_per_line - 1) >= num_samples_);
+
+static lv_obj_t* trace_lines_[num_trace_lines];
+/// Points relative to the line's position in @p trace_origins_
+static lv_point_t trace_points_[num_trace_lines][points_per_line];
+static lv_point_t trace_origins_[num_trace_lines];
+static uint8_t trace_line_idx_;
+static uint8_t trace_line_len_;
+
+static void clearTrace()
+{
+    for (uint8_t i = 0; i < num_trace_lines; i++)
+        lv_line_set_points(trace_lines_[i], trace_points_[i], 0);
+    trace_line_idx_ = 0;
+    trace_line_len_ = 0;
+}
+
+/// @param p chart coordinates
+static void appendToTraceLine(lv_point_t p)
+{
+    lv_point_t* points = trace_points_[trace_line_idx_];
+    lv_point_t& origin = trace_origins_[trace_line_idx_];
+    // Keep a margin so the line width isn't cropped at the top/left
+    lv_coord_t top = p.y - outer_margin;
+    if (trace_line_len_ == 0) {
+        origin = { static_cast<lv_coord_t>(p.x - outer_margin), top };
+    }
+    else if (top < origin.y) {
+        for (uint8_t i = 0; i < trace_line_len_; i++)
+            points[i].y += origin.y - top;
+        origin.y = top;
+    }
+    points[trace_line_len_++] = { static_cast<lv_coord_t>(p.x - origin.x), static_cast<lv_coord_t>(p.y - origin.y) };
+    lv_obj_set_pos(trace_lines_[trace_line_idx_], origin.x, origin.y);
+}
+
+/// @param p chart coordinates
+static void addTracePoint(lv_point_t p)
+{
+    if (trace_line_len_ == points_per_line) {
+        if (trace_line_idx_ + 1 == num_trace_lines)
+            return;
+        const lv_point_t& last = trace_points_[trace_line_idx_][trace_line_len_ - 1];
+        lv_point_t start = {
+                static_cast<lv_coord_t>(last.x + trace_origins_[trace_line_idx_].x),
+                static_cast<lv_coord_t>(last.y + trace_origins_[trace_line_idx_].y) };
+        trace_line_idx_++;
+        trace_line_len_ = 0;
+        appendToTraceLine(start);
+    }
+    appendToTraceLine(p);
+    lv_line_set_points(trace_lines_[trace_line_idx_], trace_points_[trace_line_idx_], trace_line_len_);
+}
 
 static void setProfile(const ReflowProfiles::Profile& profile)
 {
@@ -43,10 +105,11 @@ static void setProfile(const ReflowProfiles::Profile& profile)
     drawIdealProfile(profile, chart_);
 
     sample_idx_ = 0;
+    clearTrace();
     next_sample_time_s_ = 0;
-    secs_per_sample_ = (float)profile.getTotalDuration() / num_samples_;
-    y_pixels_per_degree_ = (float)lv_obj_get_height(chart_) / max_chart_temp;
-    x_pixels_per_sec_ = (float)lv_obj_get_width(chart_) / profile.getTotalDuration();
+    secs_per_sample_ = Q16::fromRatio(profile.getTotalDuration(), num_samples_);
+    y_pixels_per_degree_ = Q16::fromRatio(lv_obj_get_height(chart_), max_chart_temp);
+    x_pixels_per_sec_ = Q16::fromRatio(lv_obj_get_width(chart_), profile.getTotalDuration());
 }
 
 
@@ -66,39 +129,57 @@ static void populateIdealProfilePoints(
         lv_point_t (&points)[ReflowProfiles::Profile::num_profile_points],
         uint16_t width, uint16_t height)
 {
-    float x_ratio = (float)width / profile.getTotalDuration();
-    float y_ratio = (float)height / (profile.maxTemp() + temperature_mgn);
+    Q16 x_ratio = Q16::fromRatio(width, profile.getTotalDuration());
+    Q16 y_ratio = Q16::fromRatio(height, profile.maxTemp() + temperature_mgn);
 
     uint16_t x_pos = 0;
     uint8_t i = 0;
 
     points[i].x = x_pos;
-    points[i].y = height - ReflowProfiles::start_temp * y_ratio;
+    points[i].y = height - (y_ratio * ReflowProfiles::start_temp).floor();
 
-    x_pos += profile.preheat.duration * x_ratio;
+    x_pos += (x_ratio * profile.preheat.duration).floor();
     points[++i].x = x_pos;
-    points[i].y = height - profile.preheat.final_temp * y_ratio;
+    points[i].y = height - (y_ratio * profile.preheat.final_temp).floor();
 
-    x_pos += profile.soak.duration * x_ratio;
+    x_pos += (x_ratio * profile.soak.duration).floor();
     points[++i].x = x_pos;
-    points[i].y = height - profile.soak.final_temp * y_ratio;
+    points[i].y = height - (y_ratio * profile.soak.final_temp).floor();
 
-    x_pos += profile.reflow_ramp.duration * x_ratio;
+    x_pos += (x_ratio * profile.reflow_ramp.duration).floor();
     points[++i].x = x_pos;
-    points[i].y = height - profile.reflow_ramp.final_temp * y_ratio;
+    points[i].y = height - (y_ratio * profile.reflow_ramp.final_temp).floor();
 
-    x_pos += profile.reflow_dwell_duration * x_ratio;
+    x_pos += (x_ratio * profile.reflow_dwell_duration).floor();
     points[++i].x = x_pos;
     points[i].y = points[i - 1].y;
 
-    x_pos += profile.cool_duration * x_ratio;
+    x_pos += (x_ratio * profile.cool_duration).floor();
     points[++i].x = x_pos;
-    points[i].y = height - ReflowProfiles::end_temp * y_ratio;
+    points[i].y = height - (y_ratio * ReflowProfiles::end_temp).floor();
 }
 
 // Need to keep handle to invalidate on time change
 static lv_obj_t* label_elapsed_;
 static lv_obj_t* label_remaining_;
+static lv_obj_t* label_rate_;
+static ViewValue<uint16_t> shown_elapsed_;
+static ViewValue<uint32_t> shown_rate_;
+
+/// Show the estimated oven temperature rate in the current units
+static void updateRateLabel(int16_t temp_rate)
+{
+    static constexpr size_t max_len = sizeof("-99.9°F/s");
+    static char buf[max_len];
+    // Rates have no offset, only the °C -> °F scale applies
+    TempUnit units = getSettings().units;
+    int16_t rate = units == TempUnit::celsius ? temp_rate : temp_rate * 9 / 5;
+    if (!shown_rate_.changed(static_cast<uint32_t>(units) << 16 | static_cast<uint16_t>(rate)))
+        return;
+    snprintf(buf, max_len, "%s%d.%d°%c/s", rate < 0 ? "-" : "+",
+            abs(rate) / 10, abs(rate) % 10, units == TempUnit::celsius ? 'C' : 'F');
+    lv_label_set_static_text(label_rate_, buf);
+}
 
 enum class StatusText : uint8_t {
     warming = 0, dwelling, cooling
@@ -145,6 +226,7 @@ void pageReflowrunRefresh()
     updateTimeStrings(0, profile_duration_s_, false);
     lv_obj_invalidate(label_elapsed_);
     lv_obj_invalidate(label_remaining_);
+    shown_elapsed_.invalidate();
 }
 
 
@@ -181,12 +263,13 @@ void pageReflowrunInit()
     lv_obj_set_pos(profile_line_, outer_margin, outer_margin);
     lv_line_set_style(profile_line_, &style_header);
 
-    // Actual profile line
+    // Actual profile trace
 
-    actual_line_ = lv_line_create(chart_, NULL);
-    lv_obj_set_pos(actual_line_, outer_margin, outer_margin);
-    // TODO; style/color
-    lv_line_set_style(actual_line_, &style_header_status);
+    for (uint8_t i = 0; i < num_trace_lines; i++) {
+        trace_lines_[i] = lv_line_create(chart_, NULL);
+        // TODO; style/color
+        lv_line_set_style(trace_lines_[i], &style_header_status);
+    }
 
     // Labels
 
@@ -204,13 +287,23 @@ void pageReflowrunInit()
 
     updateTimeStrings(0, 0, false);
 
+    label_rate_ = createDefaultStaticLabel(chart_, "");
+    updateRateLabel(0);
+    lv_label_set_align(label_rate_, LV_LABEL_ALIGN_RIGHT);
+    lv_obj_align(label_rate_, NULL, LV_ALIGN_IN_TOP_RIGHT, -Padding::narrow, Padding::narrow);
+
     hor_pixels_per_sample_ = lv_obj_get_width(chart_) / num_samples_;
 }
 
 /// Called once warming is complete and profile begins.
 /// Draw trace of oven temp. during reflow.
-void pageReflowrunRefreshUi(uint16_t elapsed_time_s, uint16_t oven_temp, bool cooling)
+/// @p elapsed_time_s is profile time, which starts at @p start_offset_s
+/// for a warm start.
+void pageReflowrunRefreshUi(uint16_t elapsed_time_s, uint16_t start_offset_s, uint16_t oven_temp,
+        int16_t temp_rate, bool cooling)
 {
+    updateRateLabel(temp_rate);
+
     if (cooling) {
         updateStatusLabel(status_label_, StatusText::cooling);
     }
@@ -223,15 +316,22 @@ void pageReflowrunRefreshUi(uint16_t elapsed_time_s, uint16_t oven_temp, bool co
     if (elapsed_time_s >= profile_duration_s_)
         return;
 
-    updateTimeStrings(elapsed_time_s, profile_duration_s_, false);
-    lv_obj_invalidate(label_elapsed_);
-    lv_obj_invalidate(label_remaining_);
+    if (shown_elapsed_.changed(elapsed_time_s)) {
+        updateTimeStrings(elapsed_time_s - start_offset_s, profile_duration_s_ - start_offset_s, false);
+        lv_obj_invalidate(label_elapsed_);
+        lv_obj_invalidate(label_remaining_);
+    }
 
-    if (elapsed_time_s < next_sample_time_s_)
+    // Trace starts where a warm start joined the profile
+    if (sample_idx_ == 0)
+        next_sample_time_s_ = elapsed_time_s;
+    if (Q16(elapsed_time_s) < next_sample_time_s_)
         return;
 
-    sample_points_[sample_idx_].x = x_pixels_per_sec_ * elapsed_time_s;
-    sample_points_[sample_idx_++].y = lv_obj_get_height(chart_) - oven_temp * y_pixels_per_degree_;
+    lv_point_t point = {
+            static_cast<lv_coord_t>(outer_margin + (x_pixels_per_sec_ * elapsed_time_s).floor()),
+            static_cast<lv_coord_t>(outer_margin + lv_obj_get_height(chart_) - (y_pixels_per_degree_ * oven_temp).floor()) };
+    sample_idx_++;
     next_sample_time_s_ += secs_per_sample_;
-    lv_line_set_points(actual_line_, sample_points_, sample_idx_ - 1);
+    addTracePoint(point);
 }
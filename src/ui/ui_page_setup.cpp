@@ -3,9 +3,11 @@
 #include "app_settings.h"
 #include "devices/tft_led.h"
 #include "devices/speaker.h"
+#include "devices/oven_ssr.h"
 #include "ui/ui_modal.h"
 #include "ui/lvgl_tools.h"
-#include "pid/pid_algo.h"
+#include "oven/pid_ctrl.h"
+#include "oven/oven_operation.h"
 
 static lv_obj_t* cb_mute_;
 static lv_obj_t* bright_slider_;
@@ -14,13 +16,28 @@ static lv_obj_t* cb_fahrenheit_;
 static lv_obj_t* pid_p_;
 static lv_obj_t* pid_i_;
 static lv_obj_t* pid_d_;
+static lv_obj_t* rate_dl_;
+static lv_obj_t* mains_dl_;
 
-static Libp::PidAlgo* pid_;
+static PidCtrl* pid_;
+static OvenOperation* oven_operation_;
+
+/// Control rate drop down options
+static const char* rate_options = "1 Hz\n2 Hz\n5 Hz\n10 Hz";
+static constexpr uint16_t rate_periods_ms[] = { 1000, 500, 200, 100 };
+
+/// Mains frequency drop down options
+static const char* mains_options = "50Hz mains\n60Hz mains";
+static constexpr uint8_t mains_freqs[] = { 50, 60 };
 
 static bool dirty_ = false;
 static TempUnit undo_units_;
 
-static void commitChanges()
+/**
+ * @return false if the control rate could not be changed because an
+ *         operation is running. The other settings are still committed.
+ */
+static bool commitChanges()
 {
     AppSettings::Data& settings = getSettings();
     settings.brightness = lv_slider_get_value(bright_slider_);
@@ -33,6 +50,16 @@ static void commitChanges()
             settings.pid_params.ki,
             settings.pid_params.kd);
     undo_units_ = settings.units;
+    settings.mains_freq = mains_freqs[lv_ddlist_get_selected(mains_dl_)];
+    setOvenSsrMainsFreq(settings.mains_freq);
+
+    uint16_t period_ms = rate_periods_ms[lv_ddlist_get_selected(rate_dl_)];
+    if (period_ms == settings.control_period_ms)
+        return true;
+    if (!oven_operation_->setControlPeriod(period_ms))
+        return false;
+    settings.control_period_ms = period_ms;
+    return true;
 }
 
 void pageSetupRefresh()
@@ -47,6 +74,11 @@ void pageSetupRefresh()
     labelSetInt(static_cast<lv_obj_t*>(*lv_obj_get_user_data(pid_p_)), settings.pid_params.kp);
     labelSetInt(static_cast<lv_obj_t*>(*lv_obj_get_user_data(pid_i_)), settings.pid_params.ki);
     labelSetInt(static_cast<lv_obj_t*>(*lv_obj_get_user_data(pid_d_)), settings.pid_params.kd);
+    for (uint8_t i = 0; i < sizeof(rate_periods_ms) / sizeof(rate_periods_ms[0]); i++) {
+        if (rate_periods_ms[i] == settings.control_period_ms)
+            lv_ddlist_set_selected(rate_dl_, i);
+    }
+    lv_ddlist_set_selected(mains_dl_, settings.mains_freq == mains_freqs[0] ? 0 : 1);
 }
 
 void pageSetupCancel()
@@ -69,9 +101,10 @@ void pageSetupCancel()
             nullptr);
 }
 
-void pageSetupInit(Libp::PidAlgo* pid)
+void pageSetupInit(PidCtrl* pid, OvenOperation* oven_operation)
 {
     pid_ = pid;
+    oven_operation_ = oven_operation;
     lv_obj_t* page = createPage(Pages::setup);
 
     // Labels
@@ -117,10 +150,13 @@ void pageSetupInit(Libp::PidAlgo* pid)
             {
                 if (event == LV_EVENT_CLICKED) {
                     if (dirty_) {
-                        commitChanges();
+                        bool rate_applied = commitChanges();
                         if (!AppSettings::get().writeToFlash()) {
                             createModalMbox( "Failed to persist settings.", ModalMboxType::okay, nullptr, nullptr);
                         }
+                        else if (!rate_applied) {
+                            createModalMbox("Stop the oven to change\nthe control rate.", ModalMboxType::okay, nullptr, nullptr);
+                        }
                         dirty_ = false;
                     }
                     showPage(Pages::main_menu);
@@ -157,6 +193,20 @@ void pageSetupInit(Libp::PidAlgo* pid)
     pid_i_ = intEditFieldCreate(page, 1, 0, max_pid_param_value, LV_DPI / 2, LV_DPI / 4, make_dirty);
     pid_d_ = intEditFieldCreate(page, 1, 0, max_pid_param_value, LV_DPI / 2, LV_DPI / 4, make_dirty);
 
+    // Control rate, trade against thermocouple noise
+
+    rate_dl_ = lv_ddlist_create(page, NULL);
+    lv_ddlist_set_style(rate_dl_, LV_DDLIST_STYLE_SEL, &style_main_btn);
+    lv_ddlist_set_style(rate_dl_, LV_DDLIST_STYLE_BG, &style_droplist_body);
+    lv_ddlist_set_draw_arrow(rate_dl_, true);
+    lv_ddlist_set_options(rate_dl_, rate_options);
+    lv_obj_set_event_cb(rate_dl_,
+            [] (struct _lv_obj_t * obj, lv_event_t event)
+            {
+                if (event == LV_EVENT_VALUE_CHANGED)
+                    dirty_ = true;
+            });
+
     // Mute sound checkbox
 
     cb_mute_ =  createDefaultCb(page, "Mute sound", true);
@@ -169,6 +219,20 @@ void pageSetupInit(Libp::PidAlgo* pid)
                 }
             });
 
+    // Mains frequency for the SSR timing
+
+    mains_dl_ = lv_ddlist_create(page, NULL);
+    lv_ddlist_set_style(mains_dl_, LV_DDLIST_STYLE_SEL, &style_main_btn);
+    lv_ddlist_set_style(mains_dl_, LV_DDLIST_STYLE_BG, &style_droplist_body);
+    lv_ddlist_set_draw_arrow(mains_dl_, true);
+    lv_ddlist_set_options(mains_dl_, mains_options);
+    lv_obj_set_event_cb(mains_dl_,
+            [] (struct _lv_obj_t * obj, lv_event_t event)
+            {
+                if (event == LV_EVENT_VALUE_CHANGED)
+                    dirty_ = true;
+            });
+
     // Layout
 
     uint16_t btn_y_pos = lv_obj_get_height(page) - lv_obj_get_height(btn_save) - Padding::outer;
@@ -187,6 +251,8 @@ void pageSetupInit(Libp::PidAlgo* pid)
     lv_obj_set_pos(cb_mute_, ctrls_x_pos, btn_y_pos + Padding::narrow - lv_obj_get_height(cb_mute_));
     lv_obj_align(lbl_mute, cb_mute_, LV_ALIGN_OUT_LEFT_MID, -Padding::narrow, 0);
     lv_obj_set_x(lbl_mute, Padding::outer);
+    lv_obj_align(mains_dl_, cb_mute_, LV_ALIGN_OUT_RIGHT_MID, 0, 0);
+    lv_obj_set_x(mains_dl_, lv_obj_get_width(page) - lv_obj_get_width(mains_dl_) - Padding::outer);
 
     // PID and brightness 1,2 thirds between units and mute
     lv_obj_set_size(bright_slider_, lv_obj_get_width(page) - ctrls_x_pos - Padding::outer, LV_DPI / 5);
@@ -199,6 +265,7 @@ void pageSetupInit(Libp::PidAlgo* pid)
     lv_obj_set_pos(pid_p_, ctrls_x_pos + cb_padding, y_top + y_gap*2/3 -lv_obj_get_height(pid_p_)/2);
     lv_obj_align(pid_i_, pid_p_, LV_ALIGN_OUT_RIGHT_MID, Padding::inner, 0);
     lv_obj_align(pid_d_, pid_i_, LV_ALIGN_OUT_RIGHT_MID, Padding::inner, 0);
+    lv_obj_align(rate_dl_, pid_d_, LV_ALIGN_OUT_RIGHT_MID, Padding::inner, 0);
 
     lv_obj_align(lbl_pid, pid_p_, LV_ALIGN_OUT_LEFT_MID, 0, 0);
     lv_obj_set_x(lbl_pid, Padding::outer);
@@ -17,6 +17,7 @@
 #include <ui/ui_common.h>
 #include "lvgl/lvgl.h"
 #include "app_settings.h"
+#include "ui/ui_view_model.h"
 
 static lv_obj_t* header_;
 static lv_obj_t* status_label_;
@@ -70,6 +71,7 @@ static GuiPage gui_pages[] =
         nullptr, MenuLabel::setup, pageSetupCancel, pageSetupRefresh,
         nullptr, MenuLabel::about, nullptr, nullptr,
         nullptr, MenuLabel::manual, cancelManualOvenOp, nullptr,
+        nullptr, MenuLabel::queue, nullptr, pageJobQueueRefresh,
 };
 
 // Check that we have a page defined for each page defined in the Pages enum
@@ -143,11 +145,14 @@ void setTftLed(uint8_t brightness) {
 void statusHeaderUpdate(uint8_t power_level, uint16_t temp)
 {
     static constexpr size_t max_len = sizeof("100%\n999.9°C");
-    // TODO: can we just update the static text?
-    //       How to trigger label update? seems no public LV function.
     static char buf[max_len];
+    static ViewValue<uint32_t> shown_;
     TempUnit current_units = getSettings().units;
     temp = getSettings().unitsToCurrentUnits(temp, TempUnit::celsius);
+    if (!shown_.changed(static_cast<uint32_t>(power_level) << 24
+            | static_cast<uint32_t>(current_units) << 16 | temp))
+        return;
+
     if (power_level == 0)
         snprintf(buf, max_len, "Off\n%d.%d°%c",
                 (int)temp/10, (int)temp%10,
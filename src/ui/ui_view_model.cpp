@@ -0,0 +1,20 @@
+#include "ui/ui_view_model.h"
+
+static ViewStats stats_ = { };
+
+void countViewUpdate(bool redraw)
+{
+    stats_.updates++;
+    if (redraw)
+        stats_.redraws++;
+}
+
+ViewStats getViewStats()
+{
+    return stats_;
+}
+
+void resetViewStats()
+{
+    stats_ = { };
+}
@@ -0,0 +1,57 @@
+/**
+ * Last displayed values of widgets that are refreshed from the UI loop, so a
+ * widget is only updated (and redrawn) when its visible text would change.
+ */
+#ifndef UI_UI_VIEW_MODEL_H_
+#define UI_UI_VIEW_MODEL_H_
+
+#include <cstdint>
+
+struct ViewStats {
+    /// Refreshes requested
+    uint32_t updates;
+    /// Refreshes where the displayed value changed
+    uint32_t redraws;
+};
+
+void countViewUpdate(bool redraw);
+
+/**
+ * Redraws avoided = @p ViewStats::updates - @p ViewStats::redraws, since the
+ * last call to @p resetViewStats.
+ */
+ViewStats getViewStats();
+
+void resetViewStats();
+
+/**
+ * Value a widget currently shows. @p T must be comparable, e.g. the
+ * displayed number already rounded/converted to the units shown.
+ */
+template <typename T>
+class ViewValue {
+public:
+    /**
+     * Record @p value as displayed.
+     *
+     * @return true if it differs from the displayed value, i.e. the widget
+     *         needs updating
+     */
+    bool changed(T value)
+    {
+        bool redraw = !valid_ || value != value_;
+        value_ = value;
+        valid_ = true;
+        countViewUpdate(redraw);
+        return redraw;
+    }
+
+    /// Force an update on the next @p changed, e.g. when a page is reset
+    void invalidate() { valid_ = false; }
+
+private:
+    T value_ = { };
+    bool valid_ = false;
+};
+
+#endif /* UI_UI_VIEW_MODEL_H_ */